@@ -0,0 +1,55 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __BLOCKAGC_H_INCLUDED__
+#define __BLOCKAGC_H_INCLUDED__
+
+#include <complex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Opaque class structure
+typedef struct _blockagc_t blockagc_t;
+
+//  Create AGC driving the RMS level towards 'level' [dBFS]. 'alpha' is
+//  the per-block smoothing factor (0 < alpha <= 1), 'max_gain' [dB]
+//  limits amplification of an empty channel.
+blockagc_t *
+	blockagc_create (float level, float alpha, float max_gain);
+
+//  Scale block in place. The gain ramps linearly from the previous
+//  block's value to the one implied by the power tracked over earlier
+//  blocks; the power measured in this pass only takes effect from the
+//  next block on, so the gain lags the input by one block.
+void
+	blockagc_execute (blockagc_t *self, complex float *x, unsigned int n);
+
+//  Current gain [dB]
+float
+	blockagc_get_gain (blockagc_t *self);
+
+void
+	blockagc_destroy (blockagc_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCKAGC_H_INCLUDED__ */
@@ -0,0 +1,74 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __DEMOD_H_INCLUDED__
+#define __DEMOD_H_INCLUDED__
+
+#include <complex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Demodulation modes
+typedef enum {
+	DEMOD_AM = 0,		//  envelope, or synchronous with carrier tracking
+	DEMOD_NBFM,		//  FM, default deviation 5 kHz
+	DEMOD_WBFM,		//  FM, default deviation 75 kHz
+	DEMOD_USB,		//  upper sideband, default bandwidth 2.8 kHz
+	DEMOD_LSB		//  lower sideband, default bandwidth 2.8 kHz
+} demod_mode_t;
+
+//  Opaque class structure
+typedef struct _demod_t demod_t;
+
+//  Parse mode name ("am", "nbfm", "wbfm", "usb", "lsb"), returns 0 on success
+int
+	demod_mode_parse (const char *name, demod_mode_t *mode);
+
+const char *
+	demod_mode_name (demod_mode_t mode);
+
+//  Create demodulator for complex baseband at 'rate' [Hz], carrier at 0 Hz,
+//  processing blocks of up to max_samples. 'param' is the FM deviation or
+//  the SSB audio bandwidth [Hz], 0 selects the mode default; AM ignores it.
+//  SSB decimates to 8-16 times its bandwidth for the sideband filter and
+//  linearly interpolates back, which delays it by one decimated sample.
+demod_t *
+	demod_create (demod_mode_t mode, float rate, float param,
+			unsigned int max_samples);
+
+//  AM only: derotate by the tracked carrier and take the in-phase part
+//  instead of the envelope (synchronous detection, no fading distortion)
+void
+	demod_set_carrier_tracking (demod_t *self, int on);
+
+//  Demodulate block of n <= max_samples into y. Output is +-1.0 at full
+//  deviation (FM), 100% modulation (AM) or full scale input (SSB).
+void
+	demod_execute (demod_t *self, const complex float *x, unsigned int n,
+			float *y);
+
+void
+	demod_destroy (demod_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DEMOD_H_INCLUDED__ */
@@ -0,0 +1,67 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __IQ_OUTPUT_H_INCLUDED__
+#define __IQ_OUTPUT_H_INCLUDED__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <complex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Interleaved I/Q sample formats
+typedef enum {
+	IQ_FORMAT_CF32 = 0,	//  32-bit float, native endianness
+	IQ_FORMAT_CS16,		//  signed 16-bit, full scale = 1.0
+	IQ_FORMAT_CS8		//  signed 8-bit, full scale = 1.0
+} iq_format_t;
+
+//  Opaque class structure
+typedef struct _iq_output_t iq_output_t;
+
+//  Parse format name ("cf32", "cs16", "cs8"), returns 0 on success
+int
+	iq_format_parse (const char *name, iq_format_t *format);
+
+//  Size of one complex sample in bytes
+size_t
+	iq_format_sample_size (iq_format_t format);
+
+//  Create writer for blocks of up to max_samples complex samples
+iq_output_t *
+	iq_output_create (FILE *fid, iq_format_t format, unsigned int max_samples);
+
+//  Convert (with saturation) and write block, returns 0 on success
+int
+	iq_output_write (iq_output_t *self, const complex float *x, unsigned int n);
+
+//  Number of I/Q components clipped so far
+uint64_t
+	iq_output_clipped (iq_output_t *self);
+
+void
+	iq_output_destroy (iq_output_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IQ_OUTPUT_H_INCLUDED__ */
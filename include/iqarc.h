@@ -0,0 +1,133 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+/*  Chunked archive of rtl-sdr 8-bit I/Q samples.
+
+    File layout (all integers little-endian):
+
+      header   "SDRARC1\0", version, samp_rate, frequency, chunk_samples, shift
+      chunk*   "CHNK", sample_offset, timestamp [ns UTC], n_samples, shift,
+               payload_bytes, payload
+      index    (file_offset, sample_offset, timestamp, n_samples) per chunk
+      trailer  n_entries, index_offset, "SDRAIDX\0"
+
+    Each chunk decodes on its own: I and Q are delta coded against the
+    previous value of the same component, zigzag mapped and Rice coded
+    with a parameter picked per block of IQARC_KBLOCK samples. A non-zero
+    shift drops that many LSBs before coding (lossy). If the trailer is
+    missing (e.g. after a crash) the reader rebuilds the index by walking
+    the chunk headers.
+ */
+
+#ifndef __IQARC_H_INCLUDED__
+#define __IQARC_H_INCLUDED__
+
+#include <stdint.h>
+
+#include "timetag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IQARC_VERSION		1
+#define IQARC_CHUNK_SAMPLES	(1 << 20)
+#define IQARC_KBLOCK		256
+
+typedef struct {
+	uint32_t samp_rate;
+	uint64_t frequency;
+	uint32_t chunk_samples;
+	uint32_t shift;
+} iqarc_info_t;
+
+typedef struct {
+	uint64_t file_offset;
+	uint64_t sample_offset;		//  samples since start of recording
+	uint64_t timestamp;		//  UTC of first sample [ns]
+	uint32_t n_samples;
+} iqarc_index_t;
+
+//  Opaque class structures
+typedef struct _iqarc_writer_t iqarc_writer_t;
+typedef struct _iqarc_reader_t iqarc_reader_t;
+
+//  Create archive and start its encoder thread, NULL on error. The
+//  encoder always runs SCHED_OTHER, even if the caller is SCHED_FIFO,
+//  and inherits the caller's CPU affinity: create it before pinning a
+//  real-time capture thread so it stays off that thread's CPUs.
+iqarc_writer_t *
+	iqarc_writer_create (const char *filename, uint32_t samp_rate,
+				uint64_t frequency, unsigned int shift);
+
+//  Queue n interleaved I/Q samples. Unless blocking is set, never
+//  blocks: if the encoder falls behind, the samples are dropped and
+//  counted, leaving a gap in the archive's sample offsets. With 'meta' the chunks take their sample
+//  offsets and UTC timestamps from the capture tags (so capture gaps
+//  show up as well), otherwise from a local counter and clock.
+void
+	iqarc_writer_write (iqarc_writer_t *self, const uint8_t *x, unsigned int n,
+				const blockmeta_t *meta);
+
+//  Wait for the encoder when all slots are full instead of dropping;
+//  for sources that can be paused, e.g. files
+void
+	iqarc_writer_set_blocking (iqarc_writer_t *self, int on);
+
+//  Flush pending samples, stop encoder, write index. Returns 0 on success.
+int
+	iqarc_writer_close (iqarc_writer_t *self);
+
+//  Samples queued, bytes written and samples dropped so far
+void
+	iqarc_writer_stats (iqarc_writer_t *self, uint64_t *samples,
+				uint64_t *bytes, uint64_t *dropped);
+
+void
+	iqarc_writer_destroy (iqarc_writer_t **self_p);
+
+//  Open archive for reading, NULL on error
+iqarc_reader_t *
+	iqarc_reader_open (const char *filename);
+
+const iqarc_info_t *
+	iqarc_reader_info (iqarc_reader_t *self);
+
+//  Chunk index, returns number of entries
+unsigned int
+	iqarc_reader_index (iqarc_reader_t *self, const iqarc_index_t **index);
+
+//  Position at the chunk containing 'timestamp' [ns UTC]; returns its
+//  index entry number or -1 if past the end
+int
+	iqarc_reader_seek (iqarc_reader_t *self, uint64_t timestamp);
+
+//  Decode next chunk into x (2 * chunk_samples bytes). Returns number
+//  of samples, 0 at end of archive, -1 on error. 'chunk' receives the
+//  chunk's index entry if not NULL.
+int
+	iqarc_reader_read (iqarc_reader_t *self, uint8_t *x, iqarc_index_t *chunk);
+
+void
+	iqarc_reader_destroy (iqarc_reader_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IQARC_H_INCLUDED__ */
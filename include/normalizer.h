@@ -19,6 +19,9 @@
 #ifndef __NORMALIZER_H_INCLUDED__
 #define __NORMALIZER_H_INCLUDED__
 
+#include <stdint.h>
+#include <complex.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,6 +35,23 @@ normalizer_t *
 complex float
 	normalizer_normalize(normalizer_t *self, uint16_t index);
 
+//  Enable DC offset removal; block mean is tracked with smoothing
+//  factor alpha (0 < alpha <= 1, 0 = off)
+void
+	normalizer_set_dc_block(normalizer_t *self, float alpha);
+
+//  Enable blind I/Q gain and phase imbalance correction; statistics are
+//  tracked with smoothing factor alpha (0 < alpha <= 1, 0 = off)
+void
+	normalizer_set_iq_correction(normalizer_t *self, float alpha);
+
+//  Convert n interleaved 8-bit I/Q samples, applying the enabled
+//  corrections in the same pass. Corrections use the estimates from
+//  the previous blocks, so each block is read only once.
+void
+	normalizer_convert(normalizer_t *self, const uint8_t *x,
+			complex float *y, unsigned int n);
+
 void
 	normalizer_destroy (normalizer_t **self_p);
 
@@ -0,0 +1,100 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+/*  Long-term per-bin spectrum statistics kept in a memory-mapped file.
+
+    The file is a header followed by a ring of time buckets aligned to
+    wall-clock multiples of the bucket length. Each bucket holds, per
+    bin: min, max, summed linear power, count of frames above the busy
+    threshold and a histogram of levels for percentiles. Updates go
+    straight to the mapping, so the statistics survive restarts and
+    other processes can read them while capture runs; a sequence
+    counter in the header lets readers detect concurrent updates.
+ */
+
+#ifndef __OCCUPANCY_H_INCLUDED__
+#define __OCCUPANCY_H_INCLUDED__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  The histogram spans -140..+12 dBFS (a full-scale tone reads 0 dB,
+//  averaging can put a strong one a little above); levels outside it
+//  count in the end bins. Version 1 stores stopped at -12 dB.
+#define OCCUPANCY_VERSION	2
+#define OCCUPANCY_HIST_BINS	76	//  histogram bins per frequency bin
+#define OCCUPANCY_HIST_MIN	-140.0f	//  lowest histogram level [dB]
+#define OCCUPANCY_HIST_STEP	2.0f	//  histogram bin width [dB]
+
+typedef struct {
+	uint32_t nbins;
+	uint32_t n_buckets;
+	uint64_t frequency;		//  center [Hz]
+	double bandwidth;		//  span of all bins [Hz]
+	double bucket_seconds;
+	float threshold;		//  busy level [dB]
+} occupancy_info_t;
+
+typedef struct {
+	uint64_t frames;
+	float min;			//  [dB]
+	float max;
+	float mean;			//  of linear power
+	float percentile;		//  requested percentile
+	float duty;			//  fraction of frames above threshold
+} occupancy_stats_t;
+
+//  Opaque class structure
+typedef struct _occupancy_t occupancy_t;
+
+//  Open store for writing, creating it with 'info' layout if missing.
+//  An existing store must have the same layout. NULL on error, also
+//  for zero bins, buckets or bucket length.
+occupancy_t *
+	occupancy_create (const char *filename, const occupancy_info_t *info);
+
+//  Open store read-only, NULL on error
+occupancy_t *
+	occupancy_open (const char *filename);
+
+const occupancy_info_t *
+	occupancy_info (occupancy_t *self);
+
+//  Add one spectrum [dB per bin] measured at utc_ns
+void
+	occupancy_update (occupancy_t *self, const float *psd, uint64_t utc_ns);
+
+//  Statistics of one bin over buckets overlapping [from_ns, to_ns).
+//  'pct' selects the percentile (0..100). Returns 0, -1 if no data, or
+//  -2 if a writer kept the store busy for too long (e.g. it died in
+//  the middle of an update; reopening it for writing recovers).
+int
+	occupancy_query (occupancy_t *self, uint64_t from_ns, uint64_t to_ns,
+			unsigned int bin, float pct, occupancy_stats_t *stats);
+
+void
+	occupancy_destroy (occupancy_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OCCUPANCY_H_INCLUDED__ */
@@ -0,0 +1,57 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __REALTIME_H_INCLUDED__
+#define __REALTIME_H_INCLUDED__
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Opaque class structure
+typedef struct _realtime_t realtime_t;
+
+//  Switch calling thread to SCHED_FIFO at given priority, pin it to
+//  'cpus' (e.g. "1" or "0,2-3", NULL = no pinning), lock and prefault
+//  memory. 'deadline' is the duration of one block in seconds.
+//  Setup failures are reported on stderr, measurement still runs.
+realtime_t *
+	realtime_create (int priority, const char *cpus, double deadline);
+
+//  Mark the moment a block became available (i.e. read returned)
+void
+	realtime_block_begin (realtime_t *self);
+
+//  Mark the end of processing of the current block
+void
+	realtime_block_end (realtime_t *self);
+
+//  Print jitter, processing time and page fault summary
+void
+	realtime_report (realtime_t *self, FILE *fid);
+
+void
+	realtime_destroy (realtime_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REALTIME_H_INCLUDED__ */
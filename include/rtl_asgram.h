@@ -1,33 +0,0 @@
-/*  =========================================================================
-    rtl_asgram.h
-    
-    -------------------------------------------------------------------------
-    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com           
-                                                                            
-    This is free software; you can redistribute it and/or modify it under   
-    the terms of the GNU Lesser General Public License as published by the  
-    Free Software Foundation; either version 3 of the License, or (at your  
-    option) any later version.                                              
-                                                                            
-    This software is distributed in the hope that it will be useful, but    
-    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-   
-    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General  
-    Public License for more details.                                        
-                                                                            
-    You should have received a copy of the GNU Lesser General Public License
-    along with this program. If not, see http://www.gnu.org/licenses/.      
-    =========================================================================
-*/
-
-#ifndef __RTL_ASGRAM_H_INCLUDED__
-#define __RTL_ASGRAM_H_INCLUDED__
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif // __RTL_ASGRAM_H_INCLUDED__
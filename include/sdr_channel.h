@@ -0,0 +1,67 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __SDR_CHANNEL_H_INCLUDED__
+#define __SDR_CHANNEL_H_INCLUDED__
+
+#include <stdint.h>
+#include <complex.h>
+
+#include "timetag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Opaque class structure
+typedef struct _sdr_channel_t sdr_channel_t;
+
+//  Create stage resampling blocks of up to max_in samples at in_rate
+//  down to 'bandwidth' [Hz]. Each channel maps capture tags to its own
+//  output, so several channels can be fed from one source.
+sdr_channel_t *
+	sdr_channel_create (uint32_t in_rate, float bandwidth, unsigned int max_in);
+
+//  Level the output with a block AGC towards 'level' [dBFS]
+void
+	sdr_channel_set_agc (sdr_channel_t *self, float level);
+
+//  Output sample rate [Hz]
+float
+	sdr_channel_rate (sdr_channel_t *self);
+
+//  Output buffer size needed for a block of max_in samples
+unsigned int
+	sdr_channel_max_out (sdr_channel_t *self);
+
+//  Resample block x of n samples, tagged 'meta', into y. Returns the
+//  number of output samples; meta_out (may be NULL) describes them.
+//  Output tags need 'meta' for every block the channel is fed.
+unsigned int
+	sdr_channel_execute (sdr_channel_t *self, const complex float *x,
+			unsigned int n, const blockmeta_t *meta,
+			complex float *y, blockmeta_t *meta_out);
+
+void
+	sdr_channel_destroy (sdr_channel_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SDR_CHANNEL_H_INCLUDED__ */
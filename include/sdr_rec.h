@@ -0,0 +1,63 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __SDR_REC_H_INCLUDED__
+#define __SDR_REC_H_INCLUDED__
+
+//  sdr_rec library, everything needed to run the receiver chain of
+//  rtl_asgram or rtl_demod inside another program.
+//
+//  A pipeline is put together by the caller from
+//
+//    sources   sdr_source       rtl-sdr device or recorded file, raw 8-bit I/Q
+//              siggen           synthetic complex baseband test signals
+//    stages    normalizer       8-bit I/Q to complex float, DC and I/Q correction
+//              sdr_channel      resampling to the channel bandwidth, AGC
+//              demod            AM, FM and SSB demodulators
+//              tonebank         power at a few frequencies
+//              spectrum         averaged power spectrum
+//    sinks     iq_output        interleaved I/Q to a stream
+//              iqarc_writer     compressed archive
+//              occupancy        long-term spectrum statistics
+//
+//  Every call processes one block. Buffers are allocated and owned by
+//  the caller, the output of one stage is passed directly as the input
+//  of the next, and blockmeta_t tags travel alongside. Objects are not
+//  thread safe; run one pipeline per thread.
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "timetag.h"
+#include "normalizer.h"
+#include "blockagc.h"
+#include "sdr_source.h"
+#include "siggen.h"
+#include "sdr_channel.h"
+#include "demod.h"
+#include "tonebank.h"
+#include "spectrum.h"
+#include "iq_output.h"
+#include "iqarc.h"
+#include "occupancy.h"
+#include "realtime.h"
+#include "startup.h"
+
+#endif /* __SDR_REC_H_INCLUDED__ */
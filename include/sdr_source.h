@@ -0,0 +1,78 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __SDR_SOURCE_H_INCLUDED__
+#define __SDR_SOURCE_H_INCLUDED__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "timetag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Opaque class structure
+typedef struct _sdr_source_t sdr_source_t;
+
+//  Open and tune rtl-sdr device ('device' is an index or serial as
+//  accepted by -d, NULL = first device). 'gain' is in tenths of dB,
+//  0 = automatic. Returns NULL if the device cannot be opened.
+sdr_source_t *
+	sdr_source_device (char *device, uint32_t samp_rate, uint32_t frequency,
+			int gain, int ppm_error);
+
+//  Read 8-bit I/Q in rtl-sdr format from an open file, recorded at
+//  samp_rate. The file is not closed on destroy.
+sdr_source_t *
+	sdr_source_file (FILE *fid, uint32_t samp_rate);
+
+uint32_t
+	sdr_source_rate (sdr_source_t *self);
+
+//  Block tagger of this source, e.g. for timetag_lost
+timetag_t *
+	sdr_source_timetag (sdr_source_t *self);
+
+//  Flush stale device buffers, call right before the first read
+void
+	sdr_source_start (sdr_source_t *self);
+
+//  Read up to n samples (2n bytes) into the caller's buffer and tag
+//  them. Returns samples read (short only at end of file), 0 at end of
+//  file or after sdr_source_cancel, -1 on error.
+int
+	sdr_source_read (sdr_source_t *self, uint8_t *buf, unsigned int n,
+			blockmeta_t *meta);
+
+//  End the stream: every read after this returns 0. A read already in
+//  progress is not interrupted and completes with its block (one block
+//  of samples, or whatever a blocking file or pipe delivers). Only sets
+//  a flag, so it is safe from a signal handler.
+void
+	sdr_source_cancel (sdr_source_t *self);
+
+void
+	sdr_source_destroy (sdr_source_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SDR_SOURCE_H_INCLUDED__ */
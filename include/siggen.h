@@ -0,0 +1,73 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __SIGGEN_H_INCLUDED__
+#define __SIGGEN_H_INCLUDED__
+
+#include <stdint.h>
+#include <complex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIGGEN_MAX_SOURCES	16
+
+//  Opaque class structure
+typedef struct _siggen_t siggen_t;
+
+//  Create generator; output is fully determined by (samp_rate, seed)
+//  and the added sources
+siggen_t *
+	siggen_create (uint32_t samp_rate, uint32_t seed);
+
+//  Add FM modulated tone at 'offset' [Hz] from center. A deviation of 0
+//  gives a plain carrier. Returns 0 on success, -1 if full.
+int
+	siggen_add_fm_tone (siggen_t *self, float offset, float amplitude,
+				float tone, float deviation);
+
+//  Add carrier at 'offset' [Hz] keyed on for 'on' out of every
+//  'period' seconds. Returns 0 on success, -1 if full.
+int
+	siggen_add_burst (siggen_t *self, float offset, float amplitude,
+				float on, float period);
+
+//  Add complex white gaussian noise at given SNR [dB] with respect to
+//  the total power of all sources (bursts counted while keyed)
+void
+	siggen_set_snr (siggen_t *self, float snr_db);
+
+//  Generate next n samples
+void
+	siggen_generate (siggen_t *self, complex float *x, unsigned int n);
+
+//  Quantize to the rtl-sdr unsigned 8-bit interleaved format, i.e. the
+//  inverse of the normalizer mapping. Returns the number of clipped
+//  components.
+unsigned int
+	siggen_to_cu8 (const complex float *x, uint8_t *y, unsigned int n);
+
+void
+	siggen_destroy (siggen_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIGGEN_H_INCLUDED__ */
@@ -0,0 +1,72 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __SPECTRUM_H_INCLUDED__
+#define __SPECTRUM_H_INCLUDED__
+
+#include <complex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Opaque class structure
+typedef struct _spectrum_t spectrum_t;
+
+//  Create averaging power spectrum estimator with nfft bins
+spectrum_t *
+	spectrum_create (unsigned int nfft);
+
+//  Push samples; complete frames are windowed, collected and
+//  transformed a batch at a time, then added to the running average
+void
+	spectrum_write (spectrum_t *self, const complex float *x, unsigned int n);
+
+//  Number of frames averaged since the last read
+unsigned int
+	spectrum_frames (spectrum_t *self);
+
+//  Mean power per bin [dBFS, full scale tone = 0 dB] since the last
+//  read, DC in the middle (bin nfft/2). Returns frames averaged; psd
+//  is untouched if 0.
+unsigned int
+	spectrum_read (spectrum_t *self, float *psd);
+
+//  Import FFTW wisdom; from then on plans are measured, which is
+//  cheap for sizes covered by the wisdom. Returns 0 if wisdom was read,
+//  otherwise plans stay FFTW_ESTIMATE.
+int
+	spectrum_wisdom_load (const char *filename);
+
+//  Measure plans from now on without wisdom, to build a new cache
+void
+	spectrum_wisdom_measure (void);
+
+//  Export accumulated FFTW wisdom through a temporary file renamed over
+//  'filename', so readers see the old or the new file. Returns 0 on success
+int
+	spectrum_wisdom_save (const char *filename);
+
+void
+	spectrum_destroy (spectrum_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPECTRUM_H_INCLUDED__ */
@@ -0,0 +1,59 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __STARTUP_H_INCLUDED__
+#define __STARTUP_H_INCLUDED__
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STARTUP_MAX_PHASES	16
+
+//  Opaque class structure
+typedef struct _startup_t startup_t;
+
+//  Start timing; create first thing in main()
+startup_t *
+	startup_create (void);
+
+//  Record time spent since the previous mark under 'phase'
+//  (a string literal, it is not copied)
+void
+	startup_mark (startup_t *self, const char *phase);
+
+//  Print phases and total time to the last mark
+void
+	startup_report (startup_t *self, FILE *fid);
+
+//  Path of 'name' in the cache directory: 'dir' if given, otherwise
+//  $XDG_CACHE_HOME/sdr_rec or $HOME/.cache/sdr_rec. The directory is
+//  created if needed. Returns 0 on success.
+int
+	startup_cache_file (const char *dir, const char *name, char *path, size_t size);
+
+void
+	startup_destroy (startup_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STARTUP_H_INCLUDED__ */
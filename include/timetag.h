@@ -0,0 +1,101 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __TIMETAG_H_INCLUDED__
+#define __TIMETAG_H_INCLUDED__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Metadata travelling with each block of samples
+typedef struct {
+	uint64_t seq;		//  capture block sequence number
+	uint64_t sample;	//  index of first sample, at this block's rate
+	uint64_t mono_ns;	//  CLOCK_MONOTONIC of first sample [ns]
+	uint64_t utc_ns;	//  UTC of first sample [ns]
+	uint64_t gap;		//  samples lost since the previous report, see below
+	uint32_t n;		//  samples in block
+	double rate;		//  sample rate [Hz]
+} blockmeta_t;
+
+//  Mapping of capture tags to the output of one rate changing stage;
+//  each stage keeps its own, so several can share one capture
+typedef struct {
+	double rate;		//  output rate [Hz]
+	double delay;		//  filter delay [input samples]
+	double skew;		//  input samples lost so far
+	uint64_t sample;	//  index of the next output sample
+	uint64_t gap;		//  lost input samples not yet reported at output
+} timetag_map_t;
+
+//  Opaque class structure
+typedef struct _timetag_t timetag_t;
+
+//  Create tagger for a capture at samp_rate. With 'live' set, block
+//  arrival times are used to estimate sample times and detect dropped
+//  transfers; otherwise (file input) times follow the sample count.
+//  A live gap is only told from a late read once the extra delay has
+//  persisted for 8 blocks, so it is reported (and 'sample' jumps) up to
+//  8 blocks after the loss; the blocks in between keep the old sample
+//  count and times.
+timetag_t *
+	timetag_create (uint32_t samp_rate, int live);
+
+//  Tag block of n samples that has just been read
+void
+	timetag_capture (timetag_t *self, unsigned int n, blockmeta_t *meta);
+
+//  Start mapping a capture at in_rate to a stage with output rate
+//  [Hz] and filter delay [output samples]
+void
+	timetag_map_init (timetag_map_t *map, double in_rate, double rate,
+			float delay);
+
+//  Tag n output samples produced from the captured block 'in'; the
+//  stage must see every captured block. Output sample indices are
+//  contiguous; input gaps are carried over in 'gap' scaled to the
+//  output rate.
+void
+	timetag_output (timetag_map_t *map, const blockmeta_t *in, unsigned int n,
+			blockmeta_t *out);
+
+//  Total captured samples lost so far
+uint64_t
+	timetag_lost (timetag_t *self);
+
+//  Write metadata as one text line:
+//  seq sample n rate mono_ns utc_ns gap
+void
+	blockmeta_print (const blockmeta_t *meta, FILE *fid);
+
+//  Format UTC time [ns] as ISO 8601 with microseconds, buf >= 32 bytes
+void
+	timetag_format_utc (uint64_t utc_ns, char *buf, size_t size);
+
+void
+	timetag_destroy (timetag_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMETAG_H_INCLUDED__ */
@@ -0,0 +1,57 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#ifndef __TONEBANK_H_INCLUDED__
+#define __TONEBANK_H_INCLUDED__
+
+#include <stdint.h>
+#include <complex.h>
+
+#define TONEBANK_MAX_TONES	32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Opaque class structure
+typedef struct _tonebank_t tonebank_t;
+
+//  Create bank of Goertzel filters at n offsets [Hz] from center.
+//  Power is measured over Hann windowed frames of 'window' samples;
+//  cost per sample is one window multiply plus one update per tone.
+tonebank_t *
+	tonebank_create (const float *offsets, unsigned int n,
+			uint32_t samp_rate, unsigned int window);
+
+//  Feed block of samples, frames may span block boundaries
+void
+	tonebank_execute (tonebank_t *self, const complex float *x, unsigned int n);
+
+//  Mean power per tone [dBFS] over frames completed since the last call.
+//  Returns the number of frames averaged; power is untouched if 0.
+unsigned int
+	tonebank_read (tonebank_t *self, float *power);
+
+void
+	tonebank_destroy (tonebank_t **self_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TONEBANK_H_INCLUDED__ */
@@ -0,0 +1,127 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+#include <assert.h>
+
+#include "debug.h"
+#include "blockagc.h"
+
+//  independent partial sums, so the power reduction can be vectorized
+#define AGC_LANES	8
+
+struct _blockagc_t {
+	float target;		//  target power (linear)
+	float alpha;
+	float max_gain;		//  linear amplitude gain limit
+	float power;		//  smoothed input power
+	float gain;		//  amplitude gain applied at end of last block
+};
+
+blockagc_t *
+blockagc_create (float level, float alpha, float max_gain)
+{
+	blockagc_t *self = (blockagc_t *) malloc (sizeof (blockagc_t));
+	assert(self);
+
+	self->target = powf(10.0f, level / 10.0f);
+	self->alpha = alpha;
+	self->max_gain = powf(10.0f, max_gain / 20.0f);
+	self->power = 0.0f;
+	self->gain = 1.0f;
+
+	return self;
+}
+
+void
+blockagc_execute (blockagc_t *self, complex float *x, unsigned int n)
+{
+	float *xf = (float *) x;
+	float g0, step, g1;
+	float acc[AGC_LANES] = { 0.0f };
+	float p = 0.0f;
+	unsigned int i, k;
+
+	assert(self);
+	if (n == 0)
+		return;
+
+	//  ramp towards the gain implied by the power tracked so far
+	g0 = self->gain;
+	g1 = (self->power > 0.0f) ? sqrtf(self->target / self->power) : g0;
+	if (g1 > self->max_gain)
+		g1 = self->max_gain;
+	step = (g1 - g0) / n;
+
+	for (i = 0; i + AGC_LANES <= n; i += AGC_LANES) {
+		for (k = 0; k < AGC_LANES; k++) {
+			float g = g0 + step * (i + k);
+			float re = xf[2*k];
+			float im = xf[2*k + 1];
+
+			acc[k] += re * re + im * im;
+			xf[2*k]     = g * re;
+			xf[2*k + 1] = g * im;
+		}
+		xf += 2 * AGC_LANES;
+	}
+	for (; i < n; i++) {
+		float g = g0 + step * i;
+		float re = xf[0];
+		float im = xf[1];
+
+		p += re * re + im * im;
+		xf[0] = g * re;
+		xf[1] = g * im;
+		xf += 2;
+	}
+	for (k = 0; k < AGC_LANES; k++)
+		p += acc[k];
+
+	p /= n;
+	if (self->power == 0.0f)
+		self->power = p;
+	else
+		self->power += self->alpha * (p - self->power);
+	self->gain = g1;
+}
+
+float
+blockagc_get_gain (blockagc_t *self)
+{
+	assert(self);
+	return 20.0f * log10f(self->gain);
+}
+
+void
+blockagc_destroy (blockagc_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		blockagc_t *self = *self_p;
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
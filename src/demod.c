@@ -0,0 +1,615 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+#include <assert.h>
+
+#include "debug.h"
+#include "demod.h"
+
+//  Independent partial sums, so reductions vectorize without fast-math
+#define LANES		8
+
+//  Carrier rotation table length; the rotator of each chunk of ROT_BLOCK
+//  samples is computed directly, so there is no recurrence to vectorize
+#define ROT_BLOCK	64
+
+//  SSB filters at SSB_OVERSAMPLE..2*SSB_OVERSAMPLE times its bandwidth,
+//  which bounds the sideband filter to 16.5 * 2 * SSB_OVERSAMPLE taps
+#define SSB_OVERSAMPLE	8
+#define SSB_MIN_TAPS	31
+
+struct _demod_t {
+	demod_mode_t mode;
+	unsigned int max_samples;
+
+	//  FM
+	float fm_gain;		//  rate / (2 pi deviation)
+	complex float prev;	//  last sample of previous block
+
+	//  AM
+	int track;		//  synchronous detection
+	float level;		//  smoothed carrier amplitude, 0 = not yet known
+	float freq;		//  carrier frequency [rad/sample]
+	float phase;		//  carrier phase at start of next block
+	complex float *work;	//  derotated block
+	float wr[ROT_BLOCK];	//  rotation table, e^-j freq k
+	float wi[ROT_BLOCK];
+
+	//  SSB decimator, real lowpass on I and Q, taps padded to LANES
+	unsigned int decim;	//  1 = filter at the input rate
+	unsigned int dtaps;
+	float *dh;
+	float *dr, *di;		//  dtaps - 1 samples of history, then the block
+	unsigned int dpos;	//  index in the next block of its first output
+	float *ys;		//  sideband filter output at the decimated rate
+	float last, cur;	//  interpolation end points
+
+	//  SSB sideband filter, complex FIR as separate real and imaginary parts
+	unsigned int ntaps;
+	float *hr, *hi;		//  taps, time reversed
+	float *br, *bi;		//  ntaps - 1 samples of history, then the block
+};
+
+int
+demod_mode_parse (const char *name, demod_mode_t *mode)
+{
+	if (strcmp(name, "am") == 0)
+		*mode = DEMOD_AM;
+	else if (strcmp(name, "nbfm") == 0)
+		*mode = DEMOD_NBFM;
+	else if (strcmp(name, "wbfm") == 0)
+		*mode = DEMOD_WBFM;
+	else if (strcmp(name, "usb") == 0)
+		*mode = DEMOD_USB;
+	else if (strcmp(name, "lsb") == 0)
+		*mode = DEMOD_LSB;
+	else
+		return -1;
+
+	return 0;
+}
+
+const char *
+demod_mode_name (demod_mode_t mode)
+{
+	switch (mode) {
+	case DEMOD_AM:
+		return "am";
+	case DEMOD_NBFM:
+		return "nbfm";
+	case DEMOD_WBFM:
+		return "wbfm";
+	case DEMOD_USB:
+		return "usb";
+	case DEMOD_LSB:
+		return "lsb";
+	default:
+		return "?";
+	}
+}
+
+//  Windowed-sinc lowpass of the SSB bandwidth shifted up (USB) or down
+//  (LSB) by half of it, so it passes 0..bw or -bw..0. A sharp filter at
+//  the input rate would need thousands of taps, so the signal is first
+//  decimated to SSB_OVERSAMPLE times the bandwidth or a little more.
+static void
+s_ssb_taps (demod_t *self, float rate, float bw)
+{
+	unsigned int k, n, d, max_dec;
+	float fc, f0, m, sum;
+
+	d = (unsigned int)(rate / (SSB_OVERSAMPLE * bw));
+	if (d < 1)
+		d = 1;
+	self->decim = d;
+	max_dec = self->max_samples / d + 1;
+
+	if (d > 1) {
+		//  lowpass at half the decimated rate: the band edge is at
+		//  most 1/8 of it, so the Hamming transition of 3.3 / n needs
+		//  n >= 4.4 d to keep aliases out of +-bw
+		n = 5 * d;
+		self->dtaps = (n + LANES - 1) / LANES * LANES;
+		self->dh = calloc(self->dtaps, sizeof(float));
+		self->dr = calloc(self->dtaps - 1 + self->max_samples, sizeof(float));
+		self->di = calloc(self->dtaps - 1 + self->max_samples, sizeof(float));
+		self->ys = malloc(max_dec * sizeof(float));
+		assert(self->dh && self->dr && self->di && self->ys);
+
+		fc = 0.5f / d;
+		m = 0.5f * (n - 1);
+		sum = 0.0f;
+		for (k = 0; k < n; k++) {
+			float t = k - m;
+			float h = (t == 0.0f) ? 2.0f * fc :
+					sinf(2.0f * (float)M_PI * fc * t) / ((float)M_PI * t);
+			h *= 0.54f - 0.46f * cosf(2.0f * (float)M_PI * k / (n - 1));
+			self->dh[k] = h;
+			sum += h;
+		}
+		for (k = 0; k < n; k++)
+			self->dh[k] /= sum;
+		rate /= d;
+	}
+
+	//  transition band of ~20% of the bandwidth
+	fc = 0.5f * bw / rate;
+	f0 = (self->mode == DEMOD_USB) ? fc : -fc;
+	n = (unsigned int)(16.5f * rate / bw) | 1;
+	if (n < SSB_MIN_TAPS)
+		n = SSB_MIN_TAPS;
+	self->ntaps = n;
+	m = 0.5f * (n - 1);
+
+	self->hr = malloc(n * sizeof(float));
+	self->hi = malloc(n * sizeof(float));
+	self->br = calloc(n - 1 + max_dec, sizeof(float));
+	self->bi = calloc(n - 1 + max_dec, sizeof(float));
+	assert(self->hr && self->hi && self->br && self->bi);
+
+	for (k = 0; k < n; k++) {
+		float t = k - m;
+		float h = (t == 0.0f) ? 2.0f * fc :
+				sinf(2.0f * (float)M_PI * fc * t) / ((float)M_PI * t);
+		h *= 0.54f - 0.46f * cosf(2.0f * (float)M_PI * k / (n - 1));
+
+		//  reversed, so the filter loop walks the history forwards
+		self->hr[n - 1 - k] = h * cosf(2.0f * (float)M_PI * f0 * t);
+		self->hi[n - 1 - k] = h * sinf(2.0f * (float)M_PI * f0 * t);
+	}
+}
+
+demod_t *
+demod_create (demod_mode_t mode, float rate, float param,
+		unsigned int max_samples)
+{
+	demod_t *self = (demod_t *) calloc (1, sizeof (demod_t));
+	assert(self);
+
+	self->mode = mode;
+	self->max_samples = max_samples;
+
+	switch (mode) {
+	case DEMOD_NBFM:
+	case DEMOD_WBFM:
+		if (param <= 0.0f)
+			param = (mode == DEMOD_NBFM) ? 5e3f : 75e3f;
+		self->fm_gain = rate / (2.0f * (float)M_PI * param);
+		self->prev = 1.0f;
+		break;
+	case DEMOD_USB:
+	case DEMOD_LSB:
+		if (param <= 0.0f)
+			param = 2.8e3f;
+		s_ssb_taps(self, rate, param);
+		break;
+	case DEMOD_AM:
+	default:
+		self->work = malloc(max_samples * sizeof(complex float));
+		assert(self->work);
+		break;
+	}
+
+	return self;
+}
+
+void
+demod_set_carrier_tracking (demod_t *self, int on)
+{
+	assert(self);
+	self->track = on;
+}
+
+//  Add n floats into LANES partial sums; even lanes collect real parts
+//  and odd lanes imaginary parts when x is interleaved complex
+static void
+s_lane_sum (const float *restrict x, unsigned int n, float *restrict acc)
+{
+	unsigned int i, k;
+
+	for (i = 0; i + LANES <= n; i += LANES) {
+		for (k = 0; k < LANES; k++)
+			acc[k] += x[k];
+		x += LANES;
+	}
+	for (k = 0; i < n; i++, k++)
+		acc[k] += x[k];
+}
+
+//  Dot product, n a multiple of LANES
+static float
+s_dot (const float *restrict h, const float *restrict x, unsigned int n)
+{
+	float acc[LANES] = { 0.0f };
+	float sum = 0.0f;
+	unsigned int i, k;
+
+	for (i = 0; i < n; i += LANES) {
+		for (k = 0; k < LANES; k++)
+			acc[k] += h[k] * x[k];
+		h += LANES;
+		x += LANES;
+	}
+	for (k = 0; k < LANES; k++)
+		sum += acc[k];
+
+	return sum;
+}
+
+//  atan2 approximation, max error ~1e-5 rad. Branch free, so a loop
+//  around it vectorizes (libm atan2f would be a call per sample).
+static inline float
+s_atan2 (float y, float x)
+{
+	float ax = fabsf(x), ay = fabsf(y);
+	float mn = (ax < ay) ? ax : ay, mx = (ax < ay) ? ay : ax;
+	float a = mn / (mx + 1e-30f);
+	float s = a * a;
+	float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+	float t;
+
+	//  arithmetic outside the selects, so they become blends
+	//  (with -fno-trapping-math)
+	t = 1.57079637f - r;
+	r = (ay > ax) ? t : r;
+	t = 3.14159274f - r;
+	r = (x < 0.0f) ? t : r;
+	t = -r;
+	return (y < 0.0f) ? t : r;
+}
+
+//  Quadrature discriminator: phase step between consecutive samples
+static void
+s_fm (demod_t *self, const complex float *x, unsigned int n, float *y)
+{
+	const float *p = (const float *) x;	//  previous sample
+	const float *c = p + 2;			//  current sample
+	complex float d = x[0] * conjf(self->prev);
+	float g = self->fm_gain;
+	unsigned int i;
+
+	y[0] = s_atan2(cimagf(d), crealf(d)) * g;
+
+	for (i = 0; i < n - 1; i++) {
+		float re = c[0] * p[0] + c[1] * p[1];
+		float im = c[1] * p[0] - c[0] * p[1];
+		y[i+1] = s_atan2(im, re) * g;
+		p += 2;
+		c += 2;
+	}
+
+	self->prev = x[n-1];
+}
+
+//  Remove the carrier level and scale so 100% modulation is +-1.0
+static void
+s_am_level (demod_t *self, float *y, unsigned int n, float amplitude)
+{
+	float inv;
+	unsigned int i;
+
+	if (self->level == 0.0f)
+		self->level = amplitude;
+	else
+		self->level += 0.1f * (amplitude - self->level);
+
+	if (self->level <= 0.0f) {
+		memset(y, 0, n * sizeof(float));
+		return;
+	}
+
+	inv = 1.0f / self->level;
+	for (i = 0; i < n; i++)
+		y[i] = (y[i] - self->level) * inv;
+}
+
+static void
+s_magnitude (const float *restrict x, float *restrict y, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		y[i] = sqrtf(x[0] * x[0] + x[1] * x[1]);
+		x += 2;
+	}
+}
+
+static void
+s_am_envelope (demod_t *self, const complex float *x, unsigned int n, float *y)
+{
+	float acc[LANES] = { 0.0f };
+	float sum = 0.0f;
+	unsigned int k;
+
+	s_magnitude((const float *) x, y, n);
+
+	s_lane_sum(y, n, acc);
+	for (k = 0; k < LANES; k++)
+		sum += acc[k];
+
+	s_am_level(self, y, n, sum / n);
+}
+
+//  Sum of x[i] * conj(x[i-1]) over the block
+static void
+s_lag (const float *restrict a, unsigned int n, float *lr, float *li)
+{
+	const float *c = a + 2;
+	float ar[LANES] = { 0.0f }, ai[LANES] = { 0.0f };
+	unsigned int i, k;
+
+	n -= 1;
+	for (i = 0; i + LANES <= n; i += LANES) {
+		for (k = 0; k < LANES; k++) {
+			ar[k] += c[2*k] * a[2*k] + c[2*k+1] * a[2*k+1];
+			ai[k] += c[2*k+1] * a[2*k] - c[2*k] * a[2*k+1];
+		}
+		a += 2 * LANES;
+		c += 2 * LANES;
+	}
+	for (k = 0; i < n; i++, k++) {
+		ar[k] += c[2*k] * a[2*k] + c[2*k+1] * a[2*k+1];
+		ai[k] += c[2*k+1] * a[2*k] - c[2*k] * a[2*k+1];
+	}
+
+	*lr = *li = 0.0f;
+	for (k = 0; k < LANES; k++) {
+		*lr += ar[k];
+		*li += ai[k];
+	}
+}
+
+//  z = a * g * w[k], the chunk rotator g times the table entry
+static void
+s_rotate (const float *restrict a, float *restrict z,
+		const float *restrict wr, const float *restrict wi,
+		float gr, float gi, unsigned int n)
+{
+	unsigned int k;
+
+	for (k = 0; k < n; k++) {
+		float rr = gr * wr[k] - gi * wi[k];
+		float ri = gr * wi[k] + gi * wr[k];
+		z[0] = a[0] * rr - a[1] * ri;
+		z[1] = a[0] * ri + a[1] * rr;
+		a += 2;
+		z += 2;
+	}
+}
+
+//  In-phase part of z after rotating it by c
+static void
+s_inphase (const float *restrict z, float *restrict y,
+		float cr, float ci, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		y[i] = z[0] * cr - z[1] * ci;
+		z += 2;
+	}
+}
+
+//  Block feed-forward synchronous detector: the carrier frequency is
+//  estimated from the mean lag product of the block, the block is
+//  derotated and the residual phase taken from the mean of the result
+static void
+s_am_sync (demod_t *self, const complex float *x, unsigned int n, float *y)
+{
+	const float *a = (const float *) x;
+	float *z = (float *) self->work;
+	float acc[LANES] = { 0.0f };
+	float lr, li, mr = 0.0f, mi = 0.0f, cr, ci, m;
+	unsigned int i, k;
+
+	//  real arithmetic throughout, complex products would call __mulsc3
+	s_lag(a, n, &lr, &li);
+	if (lr != 0.0f || li != 0.0f)
+		self->freq = atan2f(li, lr);
+
+	for (k = 0; k < ROT_BLOCK; k++) {
+		self->wr[k] = cosf(self->freq * k);
+		self->wi[k] = -sinf(self->freq * k);
+	}
+
+	for (i = 0; i < n; i += ROT_BLOCK) {
+		double ph = self->phase + (double) self->freq * i;
+		s_rotate(a + 2*i, z + 2*i, self->wr, self->wi,
+				(float) cos(ph), (float) -sin(ph),
+				(n - i < ROT_BLOCK) ? n - i : ROT_BLOCK);
+	}
+
+	s_lane_sum(z, 2 * n, acc);
+	for (k = 0; k < LANES; k += 2) {
+		mr += acc[k];
+		mi += acc[k+1];
+	}
+
+	//  residual carrier phase, folded into the next block's start phase
+	m = sqrtf(mr * mr + mi * mi);
+	cr = (m > 0.0f) ? mr / m : 1.0f;
+	ci = (m > 0.0f) ? -mi / m : 0.0f;
+	self->phase = remainderf(self->phase + self->freq * n - atan2f(ci, cr),
+			2.0f * (float)M_PI);
+
+	s_inphase(z, y, cr, ci, n);
+
+	s_am_level(self, y, n, m / n);
+}
+
+static void
+s_deinterleave (const float *restrict x, float *restrict r,
+		float *restrict q, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		r[i] = x[0];
+		q[i] = x[1];
+		x += 2;
+	}
+}
+
+//  Real part of the complex FIR output, computed tap by tap across the
+//  whole block (no per-sample reductions)
+static void
+s_fir (const float *restrict hr, const float *restrict hi, unsigned int ntaps,
+		const float *restrict br, const float *restrict bi,
+		float *restrict y, unsigned int n)
+{
+	unsigned int i, k;
+
+	memset(y, 0, n * sizeof(float));
+	for (k = 0; k < ntaps; k++) {
+		float gr = hr[k], gi = hi[k];
+		const float *r = br + k, *q = bi + k;
+		for (i = 0; i < n; i++)
+			y[i] += gr * r[i] - gi * q[i];
+	}
+}
+
+//  Lowpass and keep every decim-th sample, writes the outputs to r, q
+static unsigned int
+s_decimate (demod_t *self, const complex float *x, unsigned int n,
+		float *r, float *q)
+{
+	unsigned int h = self->dtaps - 1;
+	unsigned int i, m = 0;
+
+	s_deinterleave((const float *) x, self->dr + h, self->di + h, n);
+
+	for (i = self->dpos; i < n; i += self->decim) {
+		r[m] = s_dot(self->dh, self->dr + i, self->dtaps);
+		q[m] = s_dot(self->dh, self->di + i, self->dtaps);
+		m++;
+	}
+	self->dpos = i - n;
+
+	memmove(self->dr, self->dr + n, h * sizeof(float));
+	memmove(self->di, self->di + n, h * sizeof(float));
+
+	return m;
+}
+
+//  y[k] = a + d * (p + k)
+static void
+s_ramp (float *restrict y, float a, float d, unsigned int p, unsigned int n)
+{
+	unsigned int k;
+
+	for (k = 0; k < n; k++)
+		y[k] = a + d * (float)(p + k);
+}
+
+//  Sideband filter at the decimated rate, then linear interpolation
+//  back to one output per input sample (one decimated sample of delay)
+static void
+s_ssb (demod_t *self, const complex float *x, unsigned int n, float *y)
+{
+	unsigned int h = self->ntaps - 1;
+	unsigned int d = self->decim;
+	unsigned int i, p, q, m;
+
+	if (d == 1) {
+		s_deinterleave((const float *) x, self->br + h, self->bi + h, n);
+		s_fir(self->hr, self->hi, self->ntaps, self->br, self->bi, y, n);
+		memmove(self->br, self->br + n, h * sizeof(float));
+		memmove(self->bi, self->bi + n, h * sizeof(float));
+		return;
+	}
+
+	//  interpolation phase of the first sample, 0 where an output is due
+	p = (d - self->dpos) % d;
+
+	m = s_decimate(self, x, n, self->br + h, self->bi + h);
+	s_fir(self->hr, self->hi, self->ntaps, self->br, self->bi, self->ys, m);
+	memmove(self->br, self->br + m, h * sizeof(float));
+	memmove(self->bi, self->bi + m, h * sizeof(float));
+
+	for (i = 0, q = 0; i < n; ) {
+		unsigned int run = d - p;
+
+		if (p == 0) {
+			self->last = self->cur;
+			self->cur = self->ys[q++];
+		}
+		if (run > n - i)
+			run = n - i;
+		s_ramp(y + i, self->last, (self->cur - self->last) / d, p, run);
+		i += run;
+		p = (p + run) % d;
+	}
+	assert(q == m);
+}
+
+void
+demod_execute (demod_t *self, const complex float *x, unsigned int n,
+		float *y)
+{
+	assert(self);
+	assert(n <= self->max_samples);
+
+	if (n == 0)
+		return;
+
+	switch (self->mode) {
+	case DEMOD_NBFM:
+	case DEMOD_WBFM:
+		s_fm(self, x, n, y);
+		break;
+	case DEMOD_USB:
+	case DEMOD_LSB:
+		s_ssb(self, x, n, y);
+		break;
+	case DEMOD_AM:
+	default:
+		if (self->track)
+			s_am_sync(self, x, n, y);
+		else
+			s_am_envelope(self, x, n, y);
+		break;
+	}
+}
+
+void
+demod_destroy (demod_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		demod_t *self = *self_p;
+
+		free (self->work);
+		free (self->hr);
+		free (self->hi);
+		free (self->br);
+		free (self->bi);
+		free (self->dh);
+		free (self->dr);
+		free (self->di);
+		free (self->ys);
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
@@ -0,0 +1,56 @@
+/*  =========================================================================
+    gen_lut - generate the normalizer conversion table at build time
+
+    -------------------------------------------------------------------------
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+
+#define LUT_SIZE	0x10000
+
+// The table is indexed by two sample bytes read as one uint16_t, so the
+// byte that lands in the low half depends on the target, not on the host
+// running gen_lut. Emit both bytes and let the target compiler order them.
+static float s_level(unsigned int byte)
+{
+    return ((float)byte - 127.4f) * (1.0f/128.0f);
+}
+
+// main program
+int main (void)
+{
+    unsigned int i;
+
+    printf("/* generated by gen_lut, do not edit */\n\n");
+    printf("#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__\n");
+    printf("#define NORMALIZER_LUT_ENTRY(lo, hi)\t{ hi, lo }\n");
+    printf("#else\n");
+    printf("#define NORMALIZER_LUT_ENTRY(lo, hi)\t{ lo, hi }\n");
+    printf("#endif\n\n");
+    printf("static const float normalizer_lut[0x%x][2] = {\n", LUT_SIZE);
+
+    // hex floats, so the table is bit exact
+    for(i = 0; i < LUT_SIZE; i++)
+        printf("\tNORMALIZER_LUT_ENTRY(%af, %af),\n",
+               s_level(i & 0xff), s_level(i >> 8));
+
+    printf("};\n\n");
+    printf("#undef NORMALIZER_LUT_ENTRY\n");
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+#include <assert.h>
+
+#include "debug.h"
+#include "iq_output.h"
+
+struct _iq_output_t {
+	FILE *fid;
+	iq_format_t format;
+	unsigned int max_samples;
+	void *buffer;		//  conversion buffer, max_samples long
+	uint64_t clipped;
+};
+
+int
+iq_format_parse (const char *name, iq_format_t *format)
+{
+	if (strcmp(name, "cf32") == 0)
+		*format = IQ_FORMAT_CF32;
+	else if (strcmp(name, "cs16") == 0)
+		*format = IQ_FORMAT_CS16;
+	else if (strcmp(name, "cs8") == 0)
+		*format = IQ_FORMAT_CS8;
+	else
+		return -1;
+
+	return 0;
+}
+
+size_t
+iq_format_sample_size (iq_format_t format)
+{
+	switch (format) {
+	case IQ_FORMAT_CS16:
+		return 2 * sizeof(int16_t);
+	case IQ_FORMAT_CS8:
+		return 2 * sizeof(int8_t);
+	case IQ_FORMAT_CF32:
+	default:
+		return 2 * sizeof(float);
+	}
+}
+
+iq_output_t *
+iq_output_create (FILE *fid, iq_format_t format, unsigned int max_samples)
+{
+	iq_output_t *self = (iq_output_t *) malloc (sizeof (iq_output_t));
+	assert(self);
+
+	self->fid = fid;
+	self->format = format;
+	self->max_samples = max_samples;
+	self->clipped = 0;
+	self->buffer = NULL;
+
+	//  cf32 is written straight from the caller's block
+	if (format != IQ_FORMAT_CF32) {
+		self->buffer = malloc(max_samples * iq_format_sample_size(format));
+		assert(self->buffer);
+	}
+
+	return self;
+}
+
+//  Scale [-1.0, 1.0] to [-fs, fs] with rounding, saturating outside that range
+static inline int32_t
+s_quantize (float f, float fs, uint64_t *clipped)
+{
+	f *= fs;
+	if (f > fs) {
+		(*clipped)++;
+		return (int32_t) fs;
+	}
+	if (f < -fs) {
+		(*clipped)++;
+		return -(int32_t) fs;
+	}
+	return (int32_t) lrintf(f);
+}
+
+int
+iq_output_write (iq_output_t *self, const complex float *x, unsigned int n)
+{
+	unsigned int i;
+	const float *xf = (const float *) x;
+	size_t written;
+
+	assert(self);
+	assert(n <= self->max_samples);
+
+	switch (self->format) {
+	case IQ_FORMAT_CS16: {
+		int16_t *y = (int16_t *) self->buffer;
+		for (i = 0; i < 2*n; i++)
+			y[i] = (int16_t) s_quantize(xf[i], 32767.0f, &self->clipped);
+		written = fwrite(y, iq_format_sample_size(self->format), n, self->fid);
+		break;
+	}
+	case IQ_FORMAT_CS8: {
+		int8_t *y = (int8_t *) self->buffer;
+		for (i = 0; i < 2*n; i++)
+			y[i] = (int8_t) s_quantize(xf[i], 127.0f, &self->clipped);
+		written = fwrite(y, iq_format_sample_size(self->format), n, self->fid);
+		break;
+	}
+	case IQ_FORMAT_CF32:
+	default:
+		written = fwrite(x, iq_format_sample_size(self->format), n, self->fid);
+		break;
+	}
+
+	return (written == n) ? 0 : -1;
+}
+
+uint64_t
+iq_output_clipped (iq_output_t *self)
+{
+	assert(self);
+	return self->clipped;
+}
+
+void
+iq_output_destroy (iq_output_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		iq_output_t *self = *self_p;
+
+		free (self->buffer);
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
@@ -0,0 +1,759 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/types.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "debug.h"
+#include "timetag.h"
+#include "iqarc.h"
+
+#define FILE_MAGIC		"SDRARC1"
+#define INDEX_MAGIC		"SDRAIDX"
+#define CHUNK_MAGIC		"CHNK"
+#define HEADER_SIZE		32
+#define CHUNK_HEADER_SIZE	32
+#define TRAILER_SIZE		24
+#define INDEX_ENTRY_SIZE	28
+#define N_SLOTS			8	//  chunks queued for the encoder
+#define Q_MAX			12	//  Rice quotient escape threshold
+#define Z_BITS			9	//  escaped zigzag value width
+
+//  Worst case payload: every value escaped, plus one k nibble per block
+#define PAYLOAD_MAX(n)		((2 * (n) * (Q_MAX + Z_BITS) + \
+				  4 * ((n) / IQARC_KBLOCK + 1)) / 8 + 8)
+
+//  --------------------------------------------------------------------------
+//  Little-endian field helpers
+
+static void
+s_put_u32 (uint8_t *p, uint32_t v)
+{
+	p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static void
+s_put_u64 (uint8_t *p, uint64_t v)
+{
+	s_put_u32(p, (uint32_t) v);
+	s_put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t
+s_get_u32 (const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t
+s_get_u64 (const uint8_t *p)
+{
+	return s_get_u32(p) | ((uint64_t) s_get_u32(p + 4) << 32);
+}
+
+//  --------------------------------------------------------------------------
+//  Rice coder
+
+typedef struct {
+	uint8_t *p;
+	uint64_t acc;
+	unsigned int nbits;
+} bitwriter_t;
+
+static inline void
+s_bits_put (bitwriter_t *bw, uint32_t v, unsigned int n)
+{
+	bw->acc = (bw->acc << n) | v;
+	bw->nbits += n;
+	while (bw->nbits >= 8) {
+		bw->nbits -= 8;
+		*bw->p++ = (uint8_t)(bw->acc >> bw->nbits);
+	}
+}
+
+static inline void
+s_bits_flush (bitwriter_t *bw)
+{
+	if (bw->nbits)
+		s_bits_put(bw, 0, 8 - bw->nbits);
+}
+
+typedef struct {
+	const uint8_t *p;
+	const uint8_t *end;
+	uint64_t acc;
+	unsigned int nbits;
+} bitreader_t;
+
+static inline uint32_t
+s_bits_get (bitreader_t *br, unsigned int n)
+{
+	while (br->nbits < n) {
+		br->acc = (br->acc << 8) | (br->p < br->end ? *br->p++ : 0);
+		br->nbits += 8;
+	}
+	br->nbits -= n;
+	return (uint32_t)(br->acc >> br->nbits) & ((1u << n) - 1);
+}
+
+//  Encode n interleaved samples, returns payload size in bytes
+static size_t
+s_encode (const uint8_t *x, unsigned int n, unsigned int shift, uint8_t *out)
+{
+	uint16_t z[2 * IQARC_KBLOCK];
+	int prev[2] = { 128 >> shift, 128 >> shift };
+	bitwriter_t bw = { out, 0, 0 };
+	unsigned int i, b;
+
+	for (b = 0; b < n; b += IQARC_KBLOCK) {
+		unsigned int len = 2 * ((n - b < IQARC_KBLOCK) ? n - b : IQARC_KBLOCK);
+		uint32_t sum = 0;
+		unsigned int k = 0;
+
+		for (i = 0; i < len; i++) {
+			int v = x[2*b + i] >> shift;
+			int r = v - prev[i & 1];
+			prev[i & 1] = v;
+			z[i] = (uint16_t)(((uint32_t) r << 1) ^ (uint32_t)(r >> 31));
+			sum += z[i];
+		}
+		//  2^k close to the mean residual
+		while (k < 8 && ((uint32_t) len << (k + 1)) <= sum)
+			k++;
+		s_bits_put(&bw, k, 4);
+
+		for (i = 0; i < len; i++) {
+			uint32_t q = z[i] >> k;
+			if (q < Q_MAX) {
+				s_bits_put(&bw, ((1u << q) - 1) << 1, q + 1);
+				s_bits_put(&bw, z[i] & ((1u << k) - 1), k);
+			} else {
+				s_bits_put(&bw, (1u << Q_MAX) - 1, Q_MAX);
+				s_bits_put(&bw, z[i], Z_BITS);
+			}
+		}
+	}
+	s_bits_flush(&bw);
+
+	return bw.p - out;
+}
+
+static void
+s_decode (const uint8_t *in, size_t size, unsigned int n, unsigned int shift,
+		uint8_t *x)
+{
+	int prev[2] = { 128 >> shift, 128 >> shift };
+	int round = shift ? 1 << (shift - 1) : 0;
+	bitreader_t br = { in, in + size, 0, 0 };
+	unsigned int i, b;
+
+	for (b = 0; b < n; b += IQARC_KBLOCK) {
+		unsigned int len = 2 * ((n - b < IQARC_KBLOCK) ? n - b : IQARC_KBLOCK);
+		unsigned int k = s_bits_get(&br, 4);
+
+		for (i = 0; i < len; i++) {
+			uint32_t q = 0, zz;
+			int r;
+
+			while (q < Q_MAX && s_bits_get(&br, 1))
+				q++;
+			if (q < Q_MAX)
+				zz = (q << k) | (k ? s_bits_get(&br, k) : 0);
+			else
+				zz = s_bits_get(&br, Z_BITS);
+			r = (int)(zz >> 1) ^ -(int)(zz & 1);
+			prev[i & 1] += r;
+			x[2*b + i] = (uint8_t)((prev[i & 1] << shift) | round);
+		}
+	}
+}
+
+//  --------------------------------------------------------------------------
+//  Writer
+
+typedef struct {
+	uint8_t *data;
+	unsigned int n;
+	uint64_t sample_offset;
+	uint64_t timestamp;
+} slot_t;
+
+struct _iqarc_writer_t {
+	FILE *fid;
+	iqarc_info_t info;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;		//  slot queued, or stop
+	pthread_cond_t space;		//  slot freed by the encoder
+	slot_t slots[N_SLOTS];
+	unsigned int head;		//  next slot to encode
+	unsigned int count;		//  slots queued for the encoder
+	int filling;			//  producer owns slot (head + count)
+	int blocking;			//  wait for a free slot instead of dropping
+	int stop;
+	int closed;
+	int error;
+
+	uint64_t samples;		//  samples passed to the writer
+	uint64_t position;		//  sample offset of next sample
+	uint64_t dropped;
+	uint64_t bytes;			//  written by encoder
+
+	uint8_t *payload;
+	iqarc_index_t *index;
+	unsigned int index_len;
+	unsigned int index_size;
+};
+
+//  Encode and write one chunk, returns bytes written
+static size_t
+s_write_chunk (iqarc_writer_t *self, slot_t *slot, uint64_t offset)
+{
+	uint8_t h[CHUNK_HEADER_SIZE];
+	size_t size;
+
+	if (self->index_len == self->index_size) {
+		self->index_size = self->index_size ? 2 * self->index_size : 1024;
+		self->index = realloc(self->index, self->index_size * sizeof(iqarc_index_t));
+		assert(self->index);
+	}
+	iqarc_index_t *e = &self->index[self->index_len++];
+	e->file_offset = offset;
+	e->sample_offset = slot->sample_offset;
+	e->timestamp = slot->timestamp;
+	e->n_samples = slot->n;
+
+	size = s_encode(slot->data, slot->n, self->info.shift, self->payload);
+
+	memset(h, 0, sizeof(h));
+	memcpy(h, CHUNK_MAGIC, 4);
+	s_put_u64(h + 4, slot->sample_offset);
+	s_put_u64(h + 12, slot->timestamp);
+	s_put_u32(h + 20, slot->n);
+	s_put_u32(h + 24, (uint32_t) size);
+	h[28] = (uint8_t) self->info.shift;
+
+	if (fwrite(h, sizeof(h), 1, self->fid) != 1 ||
+	    fwrite(self->payload, size, 1, self->fid) != 1)
+		self->error = 1;
+
+	return sizeof(h) + size;
+}
+
+static void *
+s_encoder (void *arg)
+{
+	iqarc_writer_t *self = (iqarc_writer_t *) arg;
+
+	pthread_mutex_lock(&self->lock);
+	for (;;) {
+		while (self->count == 0 && !self->stop)
+			pthread_cond_wait(&self->cond, &self->lock);
+		if (self->count == 0)
+			break;
+
+		//  slot stays owned by the encoder until count is decremented
+		slot_t *slot = &self->slots[self->head];
+		uint64_t offset = self->bytes;
+		pthread_mutex_unlock(&self->lock);
+		size_t size = s_write_chunk(self, slot, offset);
+		pthread_mutex_lock(&self->lock);
+
+		self->bytes += size;
+		self->head = (self->head + 1) % N_SLOTS;
+		self->count--;
+		pthread_cond_signal(&self->space);
+	}
+	pthread_mutex_unlock(&self->lock);
+
+	return NULL;
+}
+
+iqarc_writer_t *
+iqarc_writer_create (const char *filename, uint32_t samp_rate,
+			uint64_t frequency, unsigned int shift)
+{
+	uint8_t h[HEADER_SIZE];
+	pthread_attr_t attr;
+	struct sched_param param;
+	unsigned int i;
+
+	if (shift > 7)
+		return NULL;
+
+	FILE *fid = fopen(filename, "wb");
+	if (fid == NULL)
+		return NULL;
+
+	iqarc_writer_t *self = (iqarc_writer_t *) malloc (sizeof (iqarc_writer_t));
+	assert(self);
+	memset(self, 0, sizeof(iqarc_writer_t));
+
+	self->fid = fid;
+	self->info.samp_rate = samp_rate;
+	self->info.frequency = frequency;
+	self->info.chunk_samples = IQARC_CHUNK_SAMPLES;
+	self->info.shift = shift;
+
+	for (i = 0; i < N_SLOTS; i++) {
+		self->slots[i].data = malloc(2 * IQARC_CHUNK_SAMPLES);
+		assert(self->slots[i].data);
+	}
+	self->payload = malloc(PAYLOAD_MAX(IQARC_CHUNK_SAMPLES));
+	assert(self->payload);
+
+	memset(h, 0, sizeof(h));
+	memcpy(h, FILE_MAGIC, 8);
+	s_put_u32(h + 8, IQARC_VERSION);
+	s_put_u32(h + 12, samp_rate);
+	s_put_u64(h + 16, frequency);
+	s_put_u32(h + 24, IQARC_CHUNK_SAMPLES);
+	s_put_u32(h + 28, shift);
+	if (fwrite(h, sizeof(h), 1, fid) != 1)
+		self->error = 1;
+	self->bytes = sizeof(h);
+
+	pthread_mutex_init(&self->lock, NULL);
+	pthread_cond_init(&self->cond, NULL);
+	pthread_cond_init(&self->space, NULL);
+
+	//  the encoder is bulk work and must not compete with a real-time
+	//  capture thread, so it never inherits SCHED_FIFO from its creator
+	memset(&param, 0, sizeof(param));
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+	pthread_attr_setschedparam(&attr, &param);
+	if (pthread_create(&self->thread, &attr, s_encoder, self) != 0) {
+		debug("cannot start encoder thread");
+		pthread_attr_destroy(&attr);
+		fclose(self->fid);
+		remove(filename);
+		//  nothing to flush or join
+		self->fid = NULL;
+		self->closed = 1;
+		iqarc_writer_destroy(&self);
+		return NULL;
+	}
+	pthread_attr_destroy(&attr);
+
+	return self;
+}
+
+void
+iqarc_writer_set_blocking (iqarc_writer_t *self, int on)
+{
+	assert(self);
+	self->blocking = on;
+}
+
+//  Hand the slot being filled over to the encoder
+static void
+s_submit (iqarc_writer_t *self)
+{
+	pthread_mutex_lock(&self->lock);
+	self->count++;
+	self->filling = 0;
+	pthread_cond_signal(&self->cond);
+	pthread_mutex_unlock(&self->lock);
+}
+
+void
+iqarc_writer_write (iqarc_writer_t *self, const uint8_t *x, unsigned int n,
+			const blockmeta_t *meta)
+{
+	unsigned int done = 0;
+
+	assert(self);
+	assert(!self->closed);
+
+	//  a capture gap ends the current chunk, chunks are contiguous
+	if (meta && meta->sample != self->position) {
+		if (self->filling)
+			s_submit(self);
+		self->position = meta->sample;
+	}
+
+	while (done < n) {
+		slot_t *slot = NULL;
+		unsigned int len;
+
+		pthread_mutex_lock(&self->lock);
+		while (self->blocking && !self->filling && self->count == N_SLOTS)
+			pthread_cond_wait(&self->space, &self->lock);
+		if (self->filling || self->count < N_SLOTS)
+			slot = &self->slots[(self->head + self->count) % N_SLOTS];
+		pthread_mutex_unlock(&self->lock);
+
+		if (slot == NULL) {
+			pthread_mutex_lock(&self->lock);
+			self->dropped += n - done;
+			self->samples += n - done;
+			pthread_mutex_unlock(&self->lock);
+			self->position += n - done;
+			return;
+		}
+
+		if (!self->filling) {
+			self->filling = 1;
+			slot->n = 0;
+			slot->sample_offset = self->position;
+			if (meta) {
+				slot->timestamp = meta->utc_ns +
+					(uint64_t)(done * 1e9 / meta->rate);
+			} else {
+				struct timespec ts;
+				clock_gettime(CLOCK_REALTIME, &ts);
+				slot->timestamp = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+			}
+		}
+
+		len = IQARC_CHUNK_SAMPLES - slot->n;
+		if (len > n - done)
+			len = n - done;
+		memcpy(slot->data + 2 * slot->n, x + 2 * done, 2 * len);
+		slot->n += len;
+		pthread_mutex_lock(&self->lock);
+		self->samples += len;
+		pthread_mutex_unlock(&self->lock);
+		self->position += len;
+		done += len;
+
+		if (slot->n == IQARC_CHUNK_SAMPLES)
+			s_submit(self);
+	}
+}
+
+int
+iqarc_writer_close (iqarc_writer_t *self)
+{
+	uint8_t e[INDEX_ENTRY_SIZE];
+	uint8_t t[TRAILER_SIZE];
+	uint64_t index_offset;
+	unsigned int i;
+
+	assert(self);
+	if (self->closed)
+		return self->error ? -1 : 0;
+	self->closed = 1;
+
+	if (self->filling)
+		s_submit(self);
+
+	pthread_mutex_lock(&self->lock);
+	self->stop = 1;
+	pthread_cond_signal(&self->cond);
+	pthread_mutex_unlock(&self->lock);
+	pthread_join(self->thread, NULL);
+
+	index_offset = self->bytes;
+	for (i = 0; i < self->index_len; i++) {
+		s_put_u64(e, self->index[i].file_offset);
+		s_put_u64(e + 8, self->index[i].sample_offset);
+		s_put_u64(e + 16, self->index[i].timestamp);
+		s_put_u32(e + 24, self->index[i].n_samples);
+		if (fwrite(e, sizeof(e), 1, self->fid) != 1)
+			self->error = 1;
+	}
+	s_put_u64(t, self->index_len);
+	s_put_u64(t + 8, index_offset);
+	memcpy(t + 16, INDEX_MAGIC, 8);
+	if (fwrite(t, sizeof(t), 1, self->fid) != 1)
+		self->error = 1;
+	self->bytes += self->index_len * INDEX_ENTRY_SIZE + TRAILER_SIZE;
+
+	if (fclose(self->fid) != 0)
+		self->error = 1;
+	self->fid = NULL;
+
+	return self->error ? -1 : 0;
+}
+
+void
+iqarc_writer_stats (iqarc_writer_t *self, uint64_t *samples,
+			uint64_t *bytes, uint64_t *dropped)
+{
+	assert(self);
+	pthread_mutex_lock(&self->lock);
+	*samples = self->samples;
+	*bytes = self->bytes;
+	*dropped = self->dropped;
+	pthread_mutex_unlock(&self->lock);
+}
+
+void
+iqarc_writer_destroy (iqarc_writer_t **self_p)
+{
+	unsigned int i;
+
+	assert (self_p);
+	if (*self_p) {
+		iqarc_writer_t *self = *self_p;
+
+		iqarc_writer_close(self);
+		pthread_mutex_destroy(&self->lock);
+		pthread_cond_destroy(&self->cond);
+		pthread_cond_destroy(&self->space);
+		for (i = 0; i < N_SLOTS; i++)
+			free(self->slots[i].data);
+		free(self->payload);
+		free(self->index);
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
+
+//  --------------------------------------------------------------------------
+//  Reader
+
+struct _iqarc_reader_t {
+	FILE *fid;
+	iqarc_info_t info;
+	iqarc_index_t *index;
+	unsigned int index_len;
+	unsigned int next;		//  next chunk to decode
+	uint8_t *payload;
+};
+
+static int
+s_load_index (iqarc_reader_t *self)
+{
+	uint8_t t[TRAILER_SIZE];
+	uint8_t e[INDEX_ENTRY_SIZE];
+	uint64_t n, offset, size;
+	unsigned int i;
+	off_t end;
+
+	if (fseeko(self->fid, 0, SEEK_END) != 0 ||
+	    (end = ftello(self->fid)) < HEADER_SIZE + TRAILER_SIZE ||
+	    fseeko(self->fid, -TRAILER_SIZE, SEEK_END) != 0 ||
+	    fread(t, sizeof(t), 1, self->fid) != 1 ||
+	    memcmp(t + 16, INDEX_MAGIC, 8) != 0)
+		return -1;
+
+	//  the index must fill the space between the last chunk and the
+	//  trailer exactly, anything else is a damaged or foreign trailer
+	size = (uint64_t) end;
+	n = s_get_u64(t);
+	offset = s_get_u64(t + 8);
+	if (offset < HEADER_SIZE || offset > size - TRAILER_SIZE ||
+	    n != (size - TRAILER_SIZE - offset) / INDEX_ENTRY_SIZE ||
+	    (size - TRAILER_SIZE - offset) % INDEX_ENTRY_SIZE != 0 ||
+	    n > UINT_MAX)
+		return -1;
+	if (fseeko(self->fid, offset, SEEK_SET) != 0)
+		return -1;
+
+	self->index = malloc((n ? n : 1) * sizeof(iqarc_index_t));
+	assert(self->index);
+	for (i = 0; i < n; i++) {
+		if (fread(e, sizeof(e), 1, self->fid) != 1)
+			return -1;
+		self->index[i].file_offset = s_get_u64(e);
+		self->index[i].sample_offset = s_get_u64(e + 8);
+		self->index[i].timestamp = s_get_u64(e + 16);
+		self->index[i].n_samples = s_get_u32(e + 24);
+	}
+	self->index_len = n;
+
+	return 0;
+}
+
+//  No trailer: walk chunk headers, skipping payloads
+static void
+s_scan_index (iqarc_reader_t *self)
+{
+	uint8_t h[CHUNK_HEADER_SIZE];
+	uint64_t offset = HEADER_SIZE;
+	unsigned int size = 0;
+
+	free(self->index);
+	self->index = NULL;
+	self->index_len = 0;
+
+	while (fseeko(self->fid, offset, SEEK_SET) == 0 &&
+	       fread(h, sizeof(h), 1, self->fid) == 1 &&
+	       memcmp(h, CHUNK_MAGIC, 4) == 0) {
+		uint32_t payload_bytes = s_get_u32(h + 24);
+
+		//  drop a chunk truncated by the crash
+		if (fseeko(self->fid, offset + sizeof(h) + payload_bytes - 1, SEEK_SET) != 0 ||
+		    fgetc(self->fid) == EOF)
+			break;
+
+		if (self->index_len == size) {
+			size = size ? 2 * size : 1024;
+			self->index = realloc(self->index, size * sizeof(iqarc_index_t));
+			assert(self->index);
+		}
+		iqarc_index_t *e = &self->index[self->index_len++];
+		e->file_offset = offset;
+		e->sample_offset = s_get_u64(h + 4);
+		e->timestamp = s_get_u64(h + 12);
+		e->n_samples = s_get_u32(h + 20);
+
+		offset += sizeof(h) + payload_bytes;
+	}
+}
+
+iqarc_reader_t *
+iqarc_reader_open (const char *filename)
+{
+	uint8_t h[HEADER_SIZE];
+
+	FILE *fid = fopen(filename, "rb");
+	if (fid == NULL)
+		return NULL;
+
+	if (fread(h, sizeof(h), 1, fid) != 1 ||
+	    memcmp(h, FILE_MAGIC, 8) != 0 ||
+	    s_get_u32(h + 8) != IQARC_VERSION) {
+		fclose(fid);
+		return NULL;
+	}
+
+	iqarc_reader_t *self = (iqarc_reader_t *) malloc (sizeof (iqarc_reader_t));
+	assert(self);
+	memset(self, 0, sizeof(iqarc_reader_t));
+
+	self->fid = fid;
+	self->info.samp_rate = s_get_u32(h + 12);
+	self->info.frequency = s_get_u64(h + 16);
+	self->info.chunk_samples = s_get_u32(h + 24);
+	self->info.shift = s_get_u32(h + 28);
+
+	if (self->info.chunk_samples == 0 ||
+	    self->info.chunk_samples > IQARC_CHUNK_SAMPLES ||
+	    self->info.shift > 7 || self->info.samp_rate == 0) {
+		fclose(fid);
+		free(self);
+		return NULL;
+	}
+
+	if (s_load_index(self) != 0) {
+		debug("no index trailer, scanning chunks");
+		s_scan_index(self);
+	}
+
+	self->payload = malloc(PAYLOAD_MAX(self->info.chunk_samples));
+	assert(self->payload);
+
+	return self;
+}
+
+const iqarc_info_t *
+iqarc_reader_info (iqarc_reader_t *self)
+{
+	assert(self);
+	return &self->info;
+}
+
+unsigned int
+iqarc_reader_index (iqarc_reader_t *self, const iqarc_index_t **index)
+{
+	assert(self);
+	*index = self->index;
+	return self->index_len;
+}
+
+int
+iqarc_reader_seek (iqarc_reader_t *self, uint64_t timestamp)
+{
+	unsigned int lo = 0, hi = self->index_len;
+
+	assert(self);
+	if (self->index_len == 0)
+		return -1;
+
+	//  last chunk starting at or before timestamp
+	while (hi - lo > 1) {
+		unsigned int mid = (lo + hi) / 2;
+		if (self->index[mid].timestamp <= timestamp)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	const iqarc_index_t *e = &self->index[lo];
+	uint64_t end = e->timestamp +
+		(uint64_t) e->n_samples * 1000000000ULL / self->info.samp_rate;
+	if (lo == self->index_len - 1 && timestamp >= end)
+		return -1;
+
+	self->next = lo;
+	return lo;
+}
+
+int
+iqarc_reader_read (iqarc_reader_t *self, uint8_t *x, iqarc_index_t *chunk)
+{
+	uint8_t h[CHUNK_HEADER_SIZE];
+	uint32_t size;
+
+	assert(self);
+	if (self->next >= self->index_len)
+		return 0;
+
+	const iqarc_index_t *e = &self->index[self->next++];
+	if (fseeko(self->fid, e->file_offset, SEEK_SET) != 0 ||
+	    fread(h, sizeof(h), 1, self->fid) != 1 ||
+	    memcmp(h, CHUNK_MAGIC, 4) != 0)
+		return -1;
+
+	size = s_get_u32(h + 24);
+	if (e->n_samples > self->info.chunk_samples || h[28] > 7 ||
+	    size > PAYLOAD_MAX(self->info.chunk_samples) ||
+	    fread(self->payload, size, 1, self->fid) != 1)
+		return -1;
+
+	s_decode(self->payload, size, e->n_samples, h[28], x);
+	if (chunk)
+		*chunk = *e;
+
+	return e->n_samples;
+}
+
+void
+iqarc_reader_destroy (iqarc_reader_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		iqarc_reader_t *self = *self_p;
+
+		fclose(self->fid);
+		free(self->payload);
+		free(self->index);
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
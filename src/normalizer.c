@@ -24,39 +24,48 @@
 #include <string.h>
 #include <stdint.h>
 #include <complex.h>
+#include <math.h>
 #include <assert.h>
 
 #include "debug.h"
 #include "normalizer.h"
+#include "normalizer_lut.h"	//  generated by gen_lut
 
-#define LUT_SIZE	0x10000
-//#define IS_BIG_ENDIAN
+//  independent partial sums, so the statistics reductions can be vectorized
+#define NORM_LANES	8
 
 struct _normalizer_t {
-	float complex lut[LUT_SIZE];
+	const float complex *lut;	//  constant table, no setup at runtime
+
+	float dc_alpha;		//  DC tracking, 0 = off
+	float dc_i;		//  current DC estimate
+	float dc_q;
+
+	float iq_alpha;		//  I/Q imbalance tracking, 0 = off
+	float e_ii;		//  smoothed E[I^2], E[Q^2], E[IQ]
+	float e_qq;
+	float e_iq;
+	float iq_p;		//  Q' = iq_g * (Q - iq_p * I)
+	float iq_g;
 };
 
 
 normalizer_t *
 normalizer_create ()
 {
-	unsigned int i;
-
 	normalizer_t *self = (normalizer_t *) malloc (sizeof (normalizer_t));
 	assert(self);
 
-	for(i = 0; i < LUT_SIZE; i++)
-	{
-#ifdef IS_BIG_ENDIAN
-		self->lut[i] = (((float)(i >> 8) - 127.4f) * (1.0f/128.0f)) +
-				_Complex_I * (((float)(i & 0xff) - 127.4f) * (1.0f/128.0f));
-#else
-		self->lut[i] = (((float)(i & 0xff) - 127.4f) * (1.0f/128.0f)) +
-				_Complex_I * (((float)(i >> 8) - 127.4f) * (1.0f/128.0f));
-
-		//debug("   lut[%4u] = %12.4e + j*%12.4e;\n", i+1, crealf(self->lut[i]), cimagf(self->lut[i]));
-#endif
-	}
+	self->lut = (const float complex *) normalizer_lut;
+	self->dc_alpha = 0.0f;
+	self->dc_i = 0.0f;
+	self->dc_q = 0.0f;
+	self->iq_alpha = 0.0f;
+	self->e_ii = 0.0f;
+	self->e_qq = 0.0f;
+	self->e_iq = 0.0f;
+	self->iq_p = 0.0f;
+	self->iq_g = 1.0f;
 
 	return self;
 }
@@ -68,6 +77,115 @@ normalizer_normalize(normalizer_t *self, uint16_t index)
 
 }
 
+void
+normalizer_set_dc_block(normalizer_t *self, float alpha)
+{
+	assert(self);
+	self->dc_alpha = alpha;
+}
+
+void
+normalizer_set_iq_correction(normalizer_t *self, float alpha)
+{
+	assert(self);
+	self->iq_alpha = alpha;
+}
+
+void
+normalizer_convert(normalizer_t *self, const uint8_t *x,
+		complex float *y, unsigned int n)
+{
+	const uint16_t *idx = (const uint16_t *) x;
+	unsigned int i;
+
+	assert(self);
+
+	//  plain table lookup
+	if (self->dc_alpha == 0.0f && self->iq_alpha == 0.0f) {
+		for (i = 0; i < n; i++)
+			y[i] = self->lut[idx[i]];
+		return;
+	}
+
+	const float dc_i = self->dc_i, dc_q = self->dc_q;
+	const float p = self->iq_p, g = self->iq_g;
+	const float *lut = (const float *) self->lut;
+	float a_i[NORM_LANES] = { 0.0f }, a_q[NORM_LANES] = { 0.0f };
+	float a_ii[NORM_LANES] = { 0.0f }, a_qq[NORM_LANES] = { 0.0f };
+	float a_iq[NORM_LANES] = { 0.0f };
+	float s_i = 0.0f, s_q = 0.0f;
+	float s_ii = 0.0f, s_qq = 0.0f, s_iq = 0.0f;
+	float *yf = (float *) y;
+	unsigned int k;
+
+	//  lookup, DC removal, statistics and I/Q correction in one pass;
+	//  the table lookup stays scalar, the rest runs NORM_LANES wide
+	for (i = 0; i + NORM_LANES <= n; i += NORM_LANES) {
+		for (k = 0; k < NORM_LANES; k++) {
+			float vi = lut[2*idx[k]];
+			float vq = lut[2*idx[k] + 1];
+
+			a_i[k] += vi;
+			a_q[k] += vq;
+			vi -= dc_i;
+			vq -= dc_q;
+			a_ii[k] += vi * vi;
+			a_qq[k] += vq * vq;
+			a_iq[k] += vi * vq;
+			yf[2*k]     = vi;
+			yf[2*k + 1] = g * (vq - p * vi);
+		}
+		idx += NORM_LANES;
+		yf += 2 * NORM_LANES;
+	}
+	for (; i < n; i++) {
+		float vi = lut[2*idx[0]];
+		float vq = lut[2*idx[0] + 1];
+
+		s_i += vi;
+		s_q += vq;
+		vi -= dc_i;
+		vq -= dc_q;
+		s_ii += vi * vi;
+		s_qq += vq * vq;
+		s_iq += vi * vq;
+		yf[0] = vi;
+		yf[1] = g * (vq - p * vi);
+		idx++;
+		yf += 2;
+	}
+	for (k = 0; k < NORM_LANES; k++) {
+		s_i += a_i[k];
+		s_q += a_q[k];
+		s_ii += a_ii[k];
+		s_qq += a_qq[k];
+		s_iq += a_iq[k];
+	}
+
+	if (n == 0)
+		return;
+
+	if (self->dc_alpha > 0.0f) {
+		self->dc_i += self->dc_alpha * (s_i / n - self->dc_i);
+		self->dc_q += self->dc_alpha * (s_q / n - self->dc_q);
+	}
+
+	if (self->iq_alpha > 0.0f) {
+		self->e_ii += self->iq_alpha * (s_ii / n - self->e_ii);
+		self->e_qq += self->iq_alpha * (s_qq / n - self->e_qq);
+		self->e_iq += self->iq_alpha * (s_iq / n - self->e_iq);
+
+		//  decorrelate Q from I, then match its power to I
+		if (self->e_ii > 1e-12f) {
+			float qq = self->e_qq - self->e_iq * self->e_iq / self->e_ii;
+
+			self->iq_p = self->e_iq / self->e_ii;
+			if (qq > 1e-12f)
+				self->iq_g = sqrtf(self->e_ii / qq);
+		}
+	}
+}
+
 void
 normalizer_destroy (normalizer_t **self_p)
 {
@@ -0,0 +1,365 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "debug.h"
+#include "occupancy.h"
+
+#define MAGIC		"SDROCC1"
+#define HEADER_SIZE	128
+#define QUERY_RETRIES	100000	//  passes a reader waits for a consistent view
+
+//  On-disk header, fixed layout
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t nbins;
+	uint32_t n_buckets;
+	uint32_t hist_bins;
+	uint64_t frequency;
+	double bandwidth;
+	double bucket_seconds;
+	float threshold;
+	float hist_min;
+	float hist_step;
+	uint32_t reserved0;
+	uint64_t seq;			//  odd while an update is in progress
+	uint8_t reserved[HEADER_SIZE - 72];
+} header_t;
+
+typedef char header_size_check[(sizeof(header_t) == HEADER_SIZE) ? 1 : -1];
+
+//  Bucket: start_ns, frames, then per bin min[], max[], sum[], busy[],
+//  hist[][hist_bins]
+typedef struct {
+	uint64_t start_ns;		//  0 = empty
+	uint64_t frames;
+} bucket_t;
+
+struct _occupancy_t {
+	int fd;
+	int writable;
+	uint8_t *map;
+	size_t size;
+	size_t bucket_size;
+	header_t *hdr;
+	occupancy_info_t info;
+	uint64_t bucket_ns;
+};
+
+static size_t
+s_bucket_size (uint32_t nbins)
+{
+	return sizeof(bucket_t) +
+		nbins * (2 * sizeof(float) + sizeof(double) + sizeof(uint64_t) +
+			 OCCUPANCY_HIST_BINS * sizeof(uint32_t));
+}
+
+static bucket_t *
+s_bucket (occupancy_t *self, unsigned int i)
+{
+	return (bucket_t *)(self->map + HEADER_SIZE + i * self->bucket_size);
+}
+
+#define BIN_MIN(b)	((float *)((b) + 1))
+#define BIN_MAX(b, n)	(BIN_MIN(b) + (n))
+#define BIN_SUM(b, n)	((double *)(BIN_MAX(b, n) + (n)))
+#define BIN_BUSY(b, n)	((uint64_t *)(BIN_SUM(b, n) + (n)))
+#define BIN_HIST(b, n)	((uint32_t *)(BIN_BUSY(b, n) + (n)))
+
+static occupancy_t *
+s_map (int fd, int writable)
+{
+	struct stat st;
+	header_t hdr;
+
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < HEADER_SIZE ||
+	    pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	    memcmp(hdr.magic, MAGIC, 8) != 0 ||
+	    hdr.version != OCCUPANCY_VERSION ||
+	    hdr.hist_bins != OCCUPANCY_HIST_BINS ||
+	    hdr.nbins == 0 || hdr.n_buckets == 0 ||
+	    !((uint64_t)(hdr.bucket_seconds * 1e9) > 0) ||
+	    (size_t) st.st_size != HEADER_SIZE + hdr.n_buckets * s_bucket_size(hdr.nbins))
+		return NULL;
+
+	occupancy_t *self = (occupancy_t *) malloc (sizeof (occupancy_t));
+	assert(self);
+
+	self->fd = fd;
+	self->writable = writable;
+	self->size = st.st_size;
+	self->bucket_size = s_bucket_size(hdr.nbins);
+	self->map = mmap(NULL, self->size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+			 MAP_SHARED, fd, 0);
+	if (self->map == MAP_FAILED) {
+		free(self);
+		return NULL;
+	}
+	self->hdr = (header_t *) self->map;
+
+	self->info.nbins = hdr.nbins;
+	self->info.n_buckets = hdr.n_buckets;
+	self->info.frequency = hdr.frequency;
+	self->info.bandwidth = hdr.bandwidth;
+	self->info.bucket_seconds = hdr.bucket_seconds;
+	self->info.threshold = hdr.threshold;
+	self->bucket_ns = (uint64_t)(hdr.bucket_seconds * 1e9);
+
+	return self;
+}
+
+occupancy_t *
+occupancy_create (const char *filename, const occupancy_info_t *info)
+{
+	occupancy_t *self;
+	header_t hdr;
+
+	//  a zero bucket length or count would divide by zero on update
+	if (info->nbins == 0 || info->n_buckets == 0 ||
+	    !((uint64_t)(info->bucket_seconds * 1e9) > 0))
+		return NULL;
+
+	int fd = open(filename, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size == 0) {
+		memset(&hdr, 0, sizeof(hdr));
+		memcpy(hdr.magic, MAGIC, 8);
+		hdr.version = OCCUPANCY_VERSION;
+		hdr.nbins = info->nbins;
+		hdr.n_buckets = info->n_buckets;
+		hdr.hist_bins = OCCUPANCY_HIST_BINS;
+		hdr.frequency = info->frequency;
+		hdr.bandwidth = info->bandwidth;
+		hdr.bucket_seconds = info->bucket_seconds;
+		hdr.threshold = info->threshold;
+		hdr.hist_min = OCCUPANCY_HIST_MIN;
+		hdr.hist_step = OCCUPANCY_HIST_STEP;
+
+		//  zero filled, i.e. all buckets empty
+		if (ftruncate(fd, HEADER_SIZE + info->n_buckets * s_bucket_size(info->nbins)) != 0 ||
+		    pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+			close(fd);
+			return NULL;
+		}
+	}
+
+	self = s_map(fd, 1);
+	if (self == NULL) {
+		close(fd);
+		return NULL;
+	}
+	if (self->info.nbins != info->nbins ||
+	    self->info.n_buckets != info->n_buckets ||
+	    self->info.frequency != info->frequency ||
+	    self->info.bandwidth != info->bandwidth ||
+	    self->info.bucket_seconds != info->bucket_seconds) {
+		debug("existing store '%s' has a different layout", filename);
+		occupancy_destroy(&self);	//  closes fd
+		return NULL;
+	}
+	//  a writer killed mid-update leaves the counter odd, which would
+	//  keep readers waiting for good; its last frame may be partial
+	if (self->hdr->seq & 1) {
+		debug("store '%s' was left mid-update", filename);
+		__atomic_add_fetch(&self->hdr->seq, 1, __ATOMIC_ACQ_REL);
+	}
+	//  threshold may change between runs
+	self->hdr->threshold = info->threshold;
+	self->info.threshold = info->threshold;
+
+	return self;
+}
+
+occupancy_t *
+occupancy_open (const char *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	occupancy_t *self = s_map(fd, 0);
+	if (self == NULL)
+		close(fd);
+
+	return self;
+}
+
+const occupancy_info_t *
+occupancy_info (occupancy_t *self)
+{
+	assert(self);
+	return &self->info;
+}
+
+void
+occupancy_update (occupancy_t *self, const float *psd, uint64_t utc_ns)
+{
+	unsigned int i;
+
+	assert(self);
+	assert(self->writable);
+
+	const unsigned int n = self->info.nbins;
+	const float threshold = self->info.threshold;
+	uint64_t id = utc_ns / self->bucket_ns;
+	bucket_t *b = s_bucket(self, id % self->info.n_buckets);
+	float *min = BIN_MIN(b);
+	float *max = BIN_MAX(b, n);
+	double *sum = BIN_SUM(b, n);
+	uint64_t *busy = BIN_BUSY(b, n);
+	uint32_t *hist = BIN_HIST(b, n);
+
+	__atomic_add_fetch(&self->hdr->seq, 1, __ATOMIC_ACQ_REL);
+
+	//  bucket slot still holds an older period: start over. The
+	//  kernel writes the shared pages back; destroy syncs them.
+	if (b->start_ns != id * self->bucket_ns) {
+		memset(b, 0, self->bucket_size);
+		b->start_ns = id * self->bucket_ns;
+	}
+
+	for (i = 0; i < n; i++) {
+		float v = psd[i];
+		int h = (int)((v - OCCUPANCY_HIST_MIN) / OCCUPANCY_HIST_STEP);
+
+		if (b->frames == 0 || v < min[i])
+			min[i] = v;
+		if (b->frames == 0 || v > max[i])
+			max[i] = v;
+		sum[i] += pow(10.0, v / 10.0);
+		busy[i] += (v > threshold);
+		if (h < 0)
+			h = 0;
+		if (h >= OCCUPANCY_HIST_BINS)
+			h = OCCUPANCY_HIST_BINS - 1;
+		hist[i * OCCUPANCY_HIST_BINS + h]++;
+	}
+	b->frames++;
+
+	__atomic_add_fetch(&self->hdr->seq, 1, __ATOMIC_ACQ_REL);
+}
+
+int
+occupancy_query (occupancy_t *self, uint64_t from_ns, uint64_t to_ns,
+		unsigned int bin, float pct, occupancy_stats_t *stats)
+{
+	uint32_t hist[OCCUPANCY_HIST_BINS];
+	double sum;
+	uint64_t busy, seq;
+	unsigned int i, k, tries = 0;
+
+	assert(self);
+	const unsigned int n = self->info.nbins;
+	if (bin >= n)
+		return -1;
+
+	//  retry until a pass sees no concurrent update, giving up if the
+	//  writer never finishes (it may have died mid-update)
+	do {
+		if (tries++ == QUERY_RETRIES) {
+			debug("store stays busy, giving up");
+			return -2;
+		}
+		seq = __atomic_load_n(&self->hdr->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			sched_yield();
+			continue;
+		}
+
+		memset(hist, 0, sizeof(hist));
+		memset(stats, 0, sizeof(*stats));
+		sum = 0.0;
+		busy = 0;
+
+		for (i = 0; i < self->info.n_buckets; i++) {
+			bucket_t *b = s_bucket(self, i);
+
+			if (b->frames == 0 || b->start_ns + self->bucket_ns <= from_ns ||
+			    b->start_ns >= to_ns)
+				continue;
+
+			float vmin = BIN_MIN(b)[bin];
+			float vmax = BIN_MAX(b, n)[bin];
+			if (stats->frames == 0 || vmin < stats->min)
+				stats->min = vmin;
+			if (stats->frames == 0 || vmax > stats->max)
+				stats->max = vmax;
+			stats->frames += b->frames;
+			sum += BIN_SUM(b, n)[bin];
+			busy += BIN_BUSY(b, n)[bin];
+			for (k = 0; k < OCCUPANCY_HIST_BINS; k++)
+				hist[k] += BIN_HIST(b, n)[bin * OCCUPANCY_HIST_BINS + k];
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((seq & 1) || seq != __atomic_load_n(&self->hdr->seq, __ATOMIC_ACQUIRE));
+
+	if (stats->frames == 0)
+		return -1;
+
+	stats->mean = 10.0f * log10f((float)(sum / stats->frames) + 1e-20f);
+	stats->duty = (float) busy / stats->frames;
+
+	//  upper edge of the histogram bin reaching the percentile,
+	//  clamped to the observed range
+	uint64_t target = (uint64_t) ceil(pct / 100.0 * stats->frames), acc = 0;
+	for (k = 0; k < OCCUPANCY_HIST_BINS; k++) {
+		acc += hist[k];
+		if (acc >= target && acc > 0)
+			break;
+	}
+	stats->percentile = OCCUPANCY_HIST_MIN + (k + 1) * OCCUPANCY_HIST_STEP;
+	if (stats->percentile > stats->max)
+		stats->percentile = stats->max;
+	if (stats->percentile < stats->min)
+		stats->percentile = stats->min;
+
+	return 0;
+}
+
+void
+occupancy_destroy (occupancy_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		occupancy_t *self = *self_p;
+
+		if (self->writable)
+			msync(self->map, self->size, MS_SYNC);
+		munmap(self->map, self->size);
+		close(self->fd);
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
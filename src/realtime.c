@@ -0,0 +1,247 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "debug.h"
+#include "realtime.h"
+
+#define PREFAULT_STACK_SIZE	(512 * 1024)
+
+struct _realtime_t {
+	double deadline;		//  block duration [s]
+	int locked;			//  mlockall() succeeded
+	int scheduled;			//  SCHED_FIFO active
+
+	struct timespec begin;		//  current block start
+	struct timespec prev;		//  previous block start
+	uint64_t blocks;
+
+	double period_min;		//  time between block starts [s]
+	double period_max;
+	double period_sum;
+	double jitter_max;		//  max |period - deadline| [s]
+
+	double proc_max;		//  block processing time [s]
+	double proc_sum;
+	uint64_t over_50;		//  blocks above 50/90/100 % of deadline
+	uint64_t over_90;
+	uint64_t misses;
+
+	struct rusage ru_start;		//  at first block
+};
+
+static double
+s_elapsed (const struct timespec *a, const struct timespec *b)
+{
+	return (double)(b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+//  Touch stack pages now, so the hot loop never faults them in
+static void
+s_prefault_stack (void)
+{
+	volatile unsigned char dummy[PREFAULT_STACK_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < PREFAULT_STACK_SIZE; i += 4096)
+		dummy[i] = 0;
+	(void) dummy;
+}
+
+static int
+s_set_affinity (const char *cpus)
+{
+	cpu_set_t set;
+	const char *p = cpus;
+	char *end;
+
+	CPU_ZERO(&set);
+	while (*p) {
+		long first = strtol(p, &end, 10);
+		long last = first;
+
+		if (end == p || first < 0 || first >= CPU_SETSIZE)
+			return -1;
+		p = end;
+		if (*p == '-') {
+			last = strtol(p + 1, &end, 10);
+			if (end == p + 1 || last < first || last >= CPU_SETSIZE)
+				return -1;
+			p = end;
+		}
+		for (; first <= last; first++)
+			CPU_SET(first, &set);
+		if (*p == ',')
+			p++;
+		else if (*p)
+			return -1;
+	}
+
+	return sched_setaffinity(0, sizeof(set), &set);
+}
+
+realtime_t *
+realtime_create (int priority, const char *cpus, double deadline)
+{
+	struct sched_param param;
+
+	realtime_t *self = (realtime_t *) malloc (sizeof (realtime_t));
+	assert(self);
+	memset(self, 0, sizeof(realtime_t));
+	self->deadline = deadline;
+	self->period_min = 1e9;
+
+	//  keep freed memory in the heap and out of mmap(), so nothing
+	//  allocated later has to be faulted in again
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+		self->locked = 1;
+	else
+		fprintf(stderr, "WARNING: mlockall() failed: %s\n", strerror(errno));
+	s_prefault_stack();
+
+	if (cpus && s_set_affinity(cpus) != 0)
+		fprintf(stderr, "WARNING: failed to pin to CPUs '%s'\n", cpus);
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+	if (sched_setscheduler(0, SCHED_FIFO, &param) == 0)
+		self->scheduled = 1;
+	else
+		fprintf(stderr, "WARNING: failed to set SCHED_FIFO priority %d: %s\n",
+				priority, strerror(errno));
+
+	return self;
+}
+
+void
+realtime_block_begin (realtime_t *self)
+{
+	assert(self);
+	clock_gettime(CLOCK_MONOTONIC, &self->begin);
+
+	if (self->blocks == 0) {
+		getrusage(RUSAGE_SELF, &self->ru_start);
+	} else {
+		double period = s_elapsed(&self->prev, &self->begin);
+		double jitter = period - self->deadline;
+
+		if (jitter < 0)
+			jitter = -jitter;
+		if (period < self->period_min)
+			self->period_min = period;
+		if (period > self->period_max)
+			self->period_max = period;
+		if (jitter > self->jitter_max)
+			self->jitter_max = jitter;
+		self->period_sum += period;
+	}
+	self->prev = self->begin;
+}
+
+void
+realtime_block_end (realtime_t *self)
+{
+	struct timespec end;
+	double proc;
+
+	assert(self);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	proc = s_elapsed(&self->begin, &end);
+
+	if (proc > self->proc_max)
+		self->proc_max = proc;
+	self->proc_sum += proc;
+	if (proc > 0.5 * self->deadline)
+		self->over_50++;
+	if (proc > 0.9 * self->deadline)
+		self->over_90++;
+	if (proc > self->deadline)
+		self->misses++;
+	self->blocks++;
+}
+
+void
+realtime_report (realtime_t *self, FILE *fid)
+{
+	struct rusage ru;
+
+	assert(self);
+	if (self->blocks < 2) {
+		fprintf(fid, "realtime: not enough blocks for statistics\n");
+		return;
+	}
+	getrusage(RUSAGE_SELF, &ru);
+
+	fprintf(fid, "realtime: sched %s, memory %s\n",
+			self->scheduled ? "SCHED_FIFO" : "default",
+			self->locked ? "locked" : "not locked");
+	fprintf(fid, "blocks          :   %llu\n", (unsigned long long) self->blocks);
+	fprintf(fid, "block deadline  :   %10.3f [ms]\n", self->deadline * 1e3);
+	fprintf(fid, "period          :   %10.3f / %10.3f / %10.3f [ms] (min/mean/max)\n",
+			self->period_min * 1e3,
+			self->period_sum / (self->blocks - 1) * 1e3,
+			self->period_max * 1e3);
+	fprintf(fid, "max jitter      :   %10.3f [ms]\n", self->jitter_max * 1e3);
+	fprintf(fid, "processing      :   %10.3f / %10.3f [ms] (mean/max), max %5.1f%% of deadline\n",
+			self->proc_sum / self->blocks * 1e3,
+			self->proc_max * 1e3,
+			100.0 * self->proc_max / self->deadline);
+	fprintf(fid, "over deadline   :   >50%%: %llu  >90%%: %llu  missed: %llu\n",
+			(unsigned long long) self->over_50,
+			(unsigned long long) self->over_90,
+			(unsigned long long) self->misses);
+	fprintf(fid, "page faults     :   minor %ld, major %ld (since first block)\n",
+			ru.ru_minflt - self->ru_start.ru_minflt,
+			ru.ru_majflt - self->ru_start.ru_majflt);
+	fprintf(fid, "ctx switches    :   voluntary %ld, involuntary %ld\n",
+			ru.ru_nvcsw - self->ru_start.ru_nvcsw,
+			ru.ru_nivcsw - self->ru_start.ru_nivcsw);
+	fprintf(fid, "keeps up        :   %s\n", self->misses == 0 ? "yes" : "NO");
+}
+
+void
+realtime_destroy (realtime_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		realtime_t *self = *self_p;
+
+		if (self->locked)
+			munlockall();
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <math.h>
 #include <assert.h>
 #include <sys/resource.h>
 #include <liquid/liquid.h>
@@ -34,6 +35,15 @@
 
 #include "timer.h"
 #include "normalizer.h"
+#include "realtime.h"
+#include "timetag.h"
+#include "iqarc.h"
+#include "tonebank.h"
+#include "spectrum.h"
+#include "occupancy.h"
+#include "startup.h"
+#include "sdr_source.h"
+#include "sdr_channel.h"
 #include "debug.h"
 #include "convenience.h"
 
@@ -42,6 +52,7 @@
 #define DEFAULT_BUF_LENGTH              (4 * 1024)
 #define MINIMAL_BUF_LENGTH		512
 #define MAXIMAL_BUF_LENGTH		(256 * 16384)
+#define OCCUPANCY_AVERAGE		8	// FFT frames per occupancy update
 
 void usage() {
     printf("Usage: rtl_asgram [OPTION]\n");
@@ -60,22 +71,66 @@ void usage() {
     printf("  L     : output file log size,  default: 4096 samples\n");
     printf("  F     : output filename,       default: 'rtl_asgram.dat'\n");
     printf("  d     : device_index,          default: 0\n");
+    printf("  I     : input filename,        default: none = device, '-' = stdin\n");
+    printf("          8-bit I/Q as written by rtl_sdr or rtl_siggen\n");
+    printf("  e     : monitor mode, comma separated frequencies [Hz]\n");
+    printf("          print power at these frequencies instead of spectrogram\n");
+    printf("  w     : monitor resolution [Hz], default: 1000 Hz\n");
+    printf("  U     : occupancy store,       default: none\n");
+    printf("          accumulate per-bin statistics of the n-point spectrum\n");
+    printf("  P     : occupancy bucket [s],  default: 3600 s\n");
+    printf("  N     : occupancy buckets,     default: 168\n");
+    printf("  t     : occupancy busy level,  default: -70 dB\n");
+    printf("  W     : FFTW wisdom directory, default: ~/.cache/sdr_rec, 'none' = off\n");
+    printf("          speeds up the U and z spectrum plans only\n");
+    printf("  z     : wide-band spectrum from full-rate samples, no resampling;\n");
+    printf("          b selects the zoomed band, default when b >= samplerate\n");
+    printf("  D     : remove DC offset and correct I/Q imbalance\n");
+    printf("  a     : digital AGC level [dBFS], default: off\n");
+    printf("          resampled spectrum only, not with e or z\n");
+    printf("  A     : archive filename,      default: none\n");
+    printf("          also record raw I/Q to a compressed chunked archive\n");
+    printf("  Q     : archive LSBs to drop,  default:  0 = lossless\n");
+    printf("  R     : real-time priority,    default:  0 = off\n");
+    printf("          SCHED_FIFO, locked memory, timing report on exit\n");
+    printf("  C     : CPU list to pin to,    default: none, e.g. '2' or '0,2-3'\n");
 }
 
 static int do_exit = 0;
-static uint32_t bytes_to_read = 0;
-static rtlsdr_dev_t *dev = NULL;
+static sdr_source_t *src = NULL;
 
 static void sighandler(int signum)
 {
     fprintf(stderr, "Signal caught, exiting!\n");
     do_exit = 1;
-    rtlsdr_cancel_async(dev);
+    sdr_source_cancel(src);
+}
+
+// render psd [dB] with the asgramcf character levels
+static void ascii_render(const float *psd, unsigned int n, float offset, float scale,
+                         char *ascii, float *maxval, float *maxfreq)
+{
+    static const char levelchar[] = " .,-+*&NM#";
+    unsigned int i, j, peak = 0;
+
+    for (i=0; i<n; i++) {
+        ascii[i] = levelchar[0];
+        for (j=0; j<sizeof(levelchar)-1; j++)
+            if (psd[i] > offset + j*scale)
+                ascii[i] = levelchar[j];
+        if (psd[i] > psd[peak])
+            peak = i;
+    }
+
+    *maxval = psd[peak];
+    *maxfreq = (float)peak / (float)n - 0.5f;
 }
 
 // main program
 int main (int argc, char **argv)
 {
+    startup_t *su = startup_create();
+
     // command-line options
     int verbose = 1;
 
@@ -89,22 +144,67 @@ int main (int argc, char **argv)
     float bandwidth      = 800e3f;
     unsigned int logsize = 4096;
     char filename[256]   = "rtl_asgram.dat";
-    int r, n_read;
+    int n_read;
 
     uint32_t frequency = 100000000;
     uint32_t samp_rate = DEFAULT_SAMPLE_RATE;
     uint32_t out_block_size = DEFAULT_BUF_LENGTH;
     uint8_t *buffer;
+    complex float *buffer_norm;
 
-    int dev_index = 0;
-    int dev_given = 0;
+    char *device = NULL;
+    char input[256] = "";
+    FILE *fin = NULL;
 
     struct sigaction sigact;
     normalizer_t *norm;
 
+    int rt_priority = 0;
+    char *rt_cpus = NULL;
+    realtime_t *rt = NULL;
+
+    timetag_t *tt = NULL;
+    blockmeta_t meta, meta_out;
+
+    meta_out.n = 0;
+
+    char *arc_filename = NULL;
+    unsigned int arc_shift = 0;
+    iqarc_writer_t *arc = NULL;
+
+    int dc_block = 0;
+    int agc_on = 0;
+    float agc_level = -10.0f;
+
+    double monitor_freq[TONEBANK_MAX_TONES];    // absolute, float spacing at 1 GHz is 64 Hz
+    float monitor_offset[TONEBANK_MAX_TONES];
+    unsigned int n_monitor = 0;
+    float monitor_res = 1000.0f;
+    tonebank_t *bank = NULL;
+
+    char *occ_filename = NULL;
+    occupancy_info_t occ_info;
+    occupancy_t *occ = NULL;
+    spectrum_t *spec = NULL;
+    float *psd = NULL;
+    char *tok;
+    char *wisdom_dir = NULL;
+    int wide = 0;
+    unsigned int zoom = 1;
+    sdr_channel_t *chan = NULL;
+    char wisdom[512] = "";
+    int first = 1;
+    int last = 0;
+    int psd_new = 0;
+
+    occ_info.n_buckets = 168;
+    occ_info.bucket_seconds = 3600.0;
+    occ_info.threshold = -70.0f;
+    unsigned int i;
+
     //
     int d;
-    while ((d = getopt(argc,argv,"hf:b:B:G:n:p:s:o:r:L:F:")) != EOF) {
+    while ((d = getopt(argc,argv,"hf:b:B:G:n:p:s:o:r:L:F:R:C:I:A:Q:Da:e:w:U:P:N:t:W:z")) != EOF) {
             switch (d) {
                 case 'h':   usage();                    return 0;
                 case 'f':   frequency   = atof(optarg); break;
@@ -118,10 +218,31 @@ int main (int argc, char **argv)
                 case 'r':   fft_rate    = atof(optarg); break;
                 case 'L':   logsize     = atoi(optarg); break;
                 case 'F':   strncpy(filename,optarg,255); break;
-                case 'd':
-                    dev_index = verbose_device_search(optarg);
-                    dev_given = 1;
+                case 'I':   strncpy(input,optarg,255); break;
+                case 'e':
+                    for (tok = strtok(optarg, ","); tok; tok = strtok(NULL, ",")) {
+                        if (n_monitor == TONEBANK_MAX_TONES) {
+                            fprintf(stderr,"error: %s, at most %d monitor frequencies\n",
+                                    argv[0], TONEBANK_MAX_TONES);
+                            exit(1);
+                        }
+                        monitor_freq[n_monitor++] = atofs(tok);
+                    }
                     break;
+                case 'w':   monitor_res = atof(optarg); break;
+                case 'U':   occ_filename = optarg; break;
+                case 'P':   occ_info.bucket_seconds = atof(optarg); break;
+                case 'N':   occ_info.n_buckets = atoi(optarg); break;
+                case 't':   occ_info.threshold = atof(optarg); break;
+                case 'W':   wisdom_dir = optarg; break;
+                case 'z':   wide = 1; break;
+                case 'D':   dc_block = 1; break;
+                case 'a':   agc_level = atof(optarg); agc_on = 1; break;
+                case 'A':   arc_filename = optarg; break;
+                case 'Q':   arc_shift = atoi(optarg); break;
+                case 'R':   rt_priority = atoi(optarg); break;
+                case 'C':   rt_cpus = optarg; break;
+                case 'd':   device = optarg; break;
                 default:    usage();                    return 1;
             }
     }
@@ -132,18 +253,37 @@ int main (int argc, char **argv)
             exit(1);
     }
 
-    if (!dev_given) {
-            dev_index = verbose_device_search("0");
+    if (occ_info.bucket_seconds < 1.0 || occ_info.n_buckets == 0 || occ_info.n_buckets > 100000) {
+            fprintf(stderr,"error: %s, occupancy buckets must be at least 1 s long, 1 to 100000 of them\n", argv[0]);
+            exit(1);
     }
 
-    if (dev_index < 0) {
+    if (monitor_res <= 0.0f || monitor_res > samp_rate / 2) {
+            fprintf(stderr,"error: %s, monitor resolution must be in (0, %u] Hz\n", argv[0], samp_rate / 2);
             exit(1);
     }
 
-    r = rtlsdr_open(&dev, (uint32_t)dev_index);
-    if (r < 0) {
-            fprintf(stderr, "Failed to open rtlsdr device #%d.\n", dev_index);
-            exit(1);
+    for (i=0; i<n_monitor; i++) {
+            // difference in double, only the small offset goes to float
+            monitor_offset[i] = (float)(monitor_freq[i] - (double)frequency);
+            if (fabsf(monitor_offset[i]) >= samp_rate / 2) {
+                    fprintf(stderr,"error: %s, %.0f Hz is outside the captured band\n", argv[0], monitor_freq[i]);
+                    exit(1);
+            }
+    }
+
+    if (input[0] != '\0') {
+            // replay recorded (or rtl_siggen) samples instead of a device
+            fin = (strcmp(input, "-") == 0) ? stdin : fopen(input, "rb");
+            if (fin == NULL) {
+                    fprintf(stderr,"error: %s, could not open '%s' for reading\n", argv[0], input);
+                    exit(1);
+            }
+            src = sdr_source_file(fin, samp_rate);
+    } else {
+            src = sdr_source_device(device, samp_rate, frequency, gain, ppm_error);
+            if (src == NULL)
+                    exit(1);
     }
 
     sigact.sa_handler = sighandler;
@@ -154,49 +294,62 @@ int main (int argc, char **argv)
     sigaction(SIGQUIT, &sigact, NULL);
     sigaction(SIGPIPE, &sigact, NULL);
 
-    /* Set the sample rate */
-    verbose_set_sample_rate(dev, samp_rate);
-
-    /* Set the frequency */
-    verbose_set_frequency(dev, frequency);
-
-    if (0 == gain) {
-            /* Enable automatic gain */
-            verbose_auto_gain(dev);
-    } else {
-            /* Enable manual gain */
-            gain = nearest_gain(dev, gain);
-            verbose_gain_set(dev, gain);
+    startup_mark(su, "device");
+
+    // the resampler would have nothing to do, or the user asked for
+    // the whole band: zoom is an integer number of FFT bins per shown bin
+    if (bandwidth >= samp_rate)
+        wide = 1;
+    if (wide) {
+        zoom = (unsigned int)(samp_rate / bandwidth + 0.5f);
+        if (zoom < 1)
+            zoom = 1;
+        bandwidth = (float)samp_rate / zoom;
     }
 
-    verbose_ppm_set(dev, ppm_error);
+    // the AGC sits in the resampled channel, which the Goertzel bank
+    // and the wide-band spectrum never see
+    if (agc_on && (wide || n_monitor > 0)) {
+            fprintf(stderr,"error: %s, AGC works on the resampled spectrum only, not with -e or -z\n", argv[0]);
+            exit(1);
+    }
 
     rx_resamp_rate = bandwidth/samp_rate;
 
     printf("frequency       :   %10.4f [MHz]\n", frequency*1e-6f);
     printf("bandwidth       :   %10.4f [kHz]\n", bandwidth*1e-3f);
-    printf("sample rate     :   %10.4f kHz = %10.4f kHz * %8.6f\n",
-           samp_rate * 1e-3f,
-           bandwidth    * 1e-3f,
-           1.0f / rx_resamp_rate);
+    if (wide)
+        printf("sample rate     :   %10.4f kHz, %u-point FFT, no resampling\n",
+               samp_rate * 1e-3f, nfft * zoom);
+    else
+        printf("sample rate     :   %10.4f kHz = %10.4f kHz * %8.6f\n",
+               samp_rate * 1e-3f,
+               bandwidth    * 1e-3f,
+               1.0f / rx_resamp_rate);
     printf("verbosity       :    %s\n", (verbose?"enabled":"disabled"));
 
-    unsigned int i;
-
-    // add arbitrary resampling component
-    msresamp_crcf resamp = msresamp_crcf_create(rx_resamp_rate, 60.0f);
-    assert(resamp);
+    // arbitrary resampler (and AGC) down to the channel bandwidth
+    if (!wide) {
+        chan = sdr_channel_create(samp_rate, bandwidth, out_block_size / 2);
+        startup_mark(su, "resampler");
+    }
 
-    // create buffer for sample logging
-    windowcf log = windowcf_create(logsize);
+    // create buffer for sample logging; monitor mode never touches the
+    // samples after the tone bank, so there is nothing to log
+    windowcf log = (n_monitor == 0) ? windowcf_create(logsize) : NULL;
 
-    // create ASCII spectrogram object
+    // create ASCII spectrogram object, the wide-band path renders its
+    // own spectrum and monitor mode prints no spectrum at all
     float maxval;
     float maxfreq;
     char ascii[nfft+1];
     ascii[nfft] = '\0'; // append null character to end of string
-    asgramcf q = asgramcf_create(nfft);
-    asgramcf_set_scale(q, offset, scale);
+    asgramcf q = NULL;
+    if (!wide && n_monitor == 0) {
+        q = asgramcf_create(nfft);
+        asgramcf_set_scale(q, offset, scale);
+        startup_mark(su, "asgram");
+    }
 
     // assemble footer
     unsigned int footer_len = nfft + 16;
@@ -218,8 +371,11 @@ int main (int argc, char **argv)
     buffer = malloc(out_block_size * sizeof(uint8_t));
     assert(buffer);
 
+    buffer_norm = malloc(out_block_size / 2 * sizeof(complex float));
+    assert(buffer_norm);
+
     // create buffer for arbitrary resamper output
-    int b_len = ((int)(out_block_size * rx_resamp_rate) + 64) >> 1;
+    int b_len = chan ? sdr_channel_max_out(chan) : 1;
     complex float buffer_resamp[b_len];
     debug("resamp_buffer_len: %d", b_len);
 
@@ -228,31 +384,135 @@ int main (int argc, char **argv)
     timer_tic(t1);
 
     norm = normalizer_create();
+    if (dc_block) {
+        normalizer_set_dc_block(norm, 0.05f);
+        normalizer_set_iq_correction(norm, 0.01f);
+    }
+    startup_mark(su, "normalizer");
+
+    if (agc_on)
+        sdr_channel_set_agc(chan, agc_level);
 
-    verbose_reset_buffer(dev);
+    // Goertzel bank on the full-rate samples, no resampling or FFT
+    if (n_monitor > 0)
+        bank = tonebank_create(monitor_offset, n_monitor, samp_rate,
+                               (unsigned int)(samp_rate / monitor_res));
+
+    if (arc_filename) {
+        arc = iqarc_writer_create(arc_filename, samp_rate, frequency, arc_shift);
+        if (arc == NULL) {
+            fprintf(stderr,"error: %s, could not create archive '%s'\n", argv[0], arc_filename);
+            exit(1);
+        }
+        // a file can wait for the encoder, a device cannot
+        if (fin)
+            iqarc_writer_set_blocking(arc, 1);
+    }
+
+    tt = sdr_source_timetag(src);
+
+    if (occ_filename) {
+        if (n_monitor > 0) {
+            fprintf(stderr,"error: %s, occupancy needs the spectrum, not monitor mode\n", argv[0]);
+            exit(1);
+        }
+        occ_info.nbins = nfft;
+        occ_info.frequency = frequency;
+        occ_info.bandwidth = bandwidth;
+        occ = occupancy_create(occ_filename, &occ_info);
+        if (occ == NULL) {
+            fprintf(stderr,"error: %s, could not open occupancy store '%s'"
+                    " (or it was created with other -f/-b/-n/-P/-N, or by an older version)\n", argv[0], occ_filename);
+            exit(1);
+        }
+    }
+
+    // full-rate spectrum for the wide-band path, resampled one for
+    // occupancy otherwise
+    if (occ || (wide && n_monitor == 0)) {
+        // measured FFT plans, cached between runs; only the first run
+        // pays for measuring, an unreadable cache falls back to estimates
+        if (wisdom_dir == NULL || strcmp(wisdom_dir, "none") != 0) {
+            if (startup_cache_file(wisdom_dir, "fftwf_wisdom", wisdom, sizeof(wisdom)) != 0)
+                wisdom[0] = '\0';
+            else if (access(wisdom, F_OK) != 0)
+                spectrum_wisdom_measure();
+            else if (spectrum_wisdom_load(wisdom) != 0)
+                fprintf(stderr, "WARNING: could not read FFTW wisdom from '%s'\n", wisdom);
+        }
+        spec = spectrum_create(nfft * zoom);
+        psd = malloc(nfft * zoom * sizeof(float));
+        assert(psd);
+        startup_mark(su, "fft plan");
+    }
+
+    // after all buffers are allocated, so they get locked and prefaulted
+    if (rt_priority > 0)
+        rt = realtime_create(rt_priority, rt_cpus,
+                             (out_block_size / 2) / (double)samp_rate);
+
+    sdr_source_start(src);
 
     while (!do_exit) {
-            // grab data from device
-            r = rtlsdr_read_sync(dev, buffer, out_block_size, &n_read);
-            if (r < 0) {
+            // grab tagged block from device or file
+            n_read = sdr_source_read(src, buffer, out_block_size / 2, &meta);
+            if (n_read < 0) {
                     fprintf(stderr, "WARNING: sync read failed.\n");
                     break;
             }
+            if (n_read == 0)
+                    break;
 
-            if ((bytes_to_read > 0) && (bytes_to_read < (uint32_t)n_read)) {
-                    n_read = bytes_to_read;
-                    do_exit = 1;
+            if (first) {
+                startup_mark(su, "first block");
+                startup_report(su, stderr);
+                first = 0;
             }
 
-            // push data through arbitrary resampler and give to frame synchronizer
-            // TODO : apply bandwidth-dependent gain
-            for (i=0; i<n_read/2; i++) {
-                    // grab sample from usrp buffer
-                    complex float rtlsdr_sample = normalizer_normalize(norm, *((uint16_t*)buffer+i));
-
-                    // push through resampler (one at a time)
-                    unsigned int nw;
-                    msresamp_crcf_execute(resamp, &rtlsdr_sample, 1, buffer_resamp, &nw);
+            if (rt)
+                realtime_block_begin(rt);
+
+            if (meta.gap > 0)
+                fprintf(stderr, "WARNING: %llu samples lost, detected at block %llu\n",
+                        (unsigned long long)meta.gap, (unsigned long long)meta.seq);
+
+            // hand raw block to the archive encoder thread
+            if (arc)
+                iqarc_writer_write(arc, buffer, n_read, &meta);
+
+            // convert (with optional DC/IQ correction)
+            normalizer_convert(norm, buffer, buffer_norm, n_read);
+
+            if (bank) {
+                    tonebank_execute(bank, buffer_norm, n_read);
+            } else if (wide) {
+                    // PSD straight from the full-rate block, batched FFTs
+                    // averaged until the next display update
+                    spectrum_write(spec, buffer_norm, n_read);
+                    windowcf_write(log, buffer_norm, n_read);
+                    meta_out = meta;
+
+                    // occupancy at the same averaging as the resampled
+                    // path, not at the display rate; the display shows
+                    // the latest of these averages
+                    if (occ && spectrum_frames(spec) >= OCCUPANCY_AVERAGE) {
+                        spectrum_read(spec, psd);
+                        occupancy_update(occ, psd + nfft * zoom / 2 - nfft / 2, meta.utc_ns);
+                        psd_new = 1;
+                    }
+            } else {
+                    // push whole block through arbitrary resampler
+                    unsigned int nw = sdr_channel_execute(chan, buffer_norm, n_read, &meta,
+                                                          buffer_resamp, &meta_out);
+
+                    // long-term per-bin statistics from averaged spectra
+                    if (occ) {
+                        spectrum_write(spec, buffer_resamp, nw);
+                        if (spectrum_frames(spec) >= OCCUPANCY_AVERAGE) {
+                            spectrum_read(spec, psd);
+                            occupancy_update(occ, psd, meta_out.utc_ns);
+                        }
+                    }
 
                     // push resulting samples into asgram object
                     asgramcf_write(q, buffer_resamp, nw);
@@ -261,37 +521,83 @@ int main (int argc, char **argv)
                     windowcf_write(log, buffer_resamp, nw);
             }
 
-            if ((uint32_t)n_read < out_block_size) {
-                    fprintf(stderr, "Short read, samples lost, exiting!\n");
-                    break;
+            if ((uint32_t)n_read < out_block_size / 2) {
+                    if (fin == NULL)
+                            fprintf(stderr, "Short read, samples lost, exiting!\n");
+                    last = 1;
             }
 
-            if (bytes_to_read > 0)
-                bytes_to_read -= n_read;
-
             if (timer_toc(t1) > msdelay*1e-3f) {
                     // reset timer
                     timer_tic(t1);
 
-                    // run the spectrogram
-                    asgramcf_execute(q, ascii, &maxval, &maxfreq);
-
-                    // print the spectrogram
-                    printf(" > %s < pk%5.1fdB [%5.2f]\n", ascii, maxval, maxfreq);
-                    printf("%s\r", footer);
-                    fflush(stdout);
+                    if (bank) {
+                            float power[TONEBANK_MAX_TONES];
+
+                            // print power at monitored frequencies
+                            if (tonebank_read(bank, power) > 0) {
+                                    char utc[32];
+
+                                    timetag_format_utc(meta.utc_ns, utc, sizeof(utc));
+                                    printf("%s", utc);
+                                    for (i=0; i<n_monitor; i++)
+                                        printf(" %10.6f MHz %6.1fdB", monitor_freq[i]*1e-6, power[i]);
+                                    printf("\n");
+                                    fflush(stdout);
+                            }
+                    } else if (wide) {
+                            // zoom by picking the bins of the shown band
+                            if (occ ? psd_new : spectrum_read(spec, psd) > 0) {
+                                    float *band = psd + nfft * zoom / 2 - nfft / 2;
+
+                                    ascii_render(band, nfft, offset, scale, ascii, &maxval, &maxfreq);
+                                    psd_new = 0;
+
+                                    printf(" > %s < pk%5.1fdB [%5.2f]\n", ascii, maxval, maxfreq);
+                                    printf("%s\r", footer);
+                                    fflush(stdout);
+                            }
+                    } else {
+                            // run the spectrogram
+                            asgramcf_execute(q, ascii, &maxval, &maxfreq);
+
+                            // print the spectrogram
+                            printf(" > %s < pk%5.1fdB [%5.2f]\n", ascii, maxval, maxfreq);
+                            printf("%s\r", footer);
+                            fflush(stdout);
+                    }
             }
+
+            // close the block's deadline accounting before leaving
+            if (rt)
+                realtime_block_end(rt);
+            if (last)
+                break;
     }
 
     // try to write samples to file
-    FILE * fid = fopen(filename,"w");
+    FILE * fid = log ? fopen(filename,"w") : NULL;
     if (fid != NULL) {
             // write header
             fprintf(fid, "# %s : auto-generated file\n", filename);
             fprintf(fid, "#\n");
             fprintf(fid, "# num_samples :   %u\n", logsize);
             fprintf(fid, "# frequency   :   %12.8f MHz\n", frequency*1e-6f);
-            fprintf(fid, "# bandwidth   :   %12.8f kHz\n", bandwidth*1e-3f);
+            // the wide-band log holds full-rate samples, not the zoomed band
+            fprintf(fid, "# bandwidth   :   %12.8f kHz\n",
+                    (wide ? (float)samp_rate : bandwidth)*1e-3f);
+
+            // log ends with the last block written to it
+            if (meta_out.n > 0) {
+                    char utc[32];
+                    int64_t first_sample = (int64_t)(meta_out.sample + meta_out.n) - logsize;
+
+                    timetag_format_utc(meta_out.utc_ns +
+                            (int64_t)((first_sample - (int64_t)meta_out.sample) * 1e9 / meta_out.rate),
+                            utc, sizeof(utc));
+                    fprintf(fid, "# first sample:   %lld\n", (long long)first_sample);
+                    fprintf(fid, "# utc         :   %s\n", utc);
+            }
 
             // save results to file
             complex float * rc;   // read pointer
@@ -302,18 +608,51 @@ int main (int argc, char **argv)
             // close it up
             fclose(fid);
             printf("results written to '%s'\n", filename);
-    } else {
+    } else if (log) {
             fprintf(stderr,"error: %s, could not open '%s' for writing\n", argv[0], filename);
     }
 
+    if (rt)
+        realtime_report(rt, stderr);
+
+    if (timetag_lost(tt) > 0)
+        fprintf(stderr, "samples lost    :   %llu\n", (unsigned long long)timetag_lost(tt));
+
+    if (arc) {
+        uint64_t arc_samples, arc_bytes, arc_dropped;
+
+        if (iqarc_writer_close(arc) != 0)
+            fprintf(stderr, "WARNING: error writing archive '%s'\n", arc_filename);
+        iqarc_writer_stats(arc, &arc_samples, &arc_bytes, &arc_dropped);
+        fprintf(stderr, "archive         :   %llu samples, %llu bytes (%5.1f%%), %llu dropped\n",
+                (unsigned long long)arc_samples, (unsigned long long)arc_bytes,
+                arc_samples ? 100.0 * arc_bytes / (2.0 * arc_samples) : 0.0,
+                (unsigned long long)arc_dropped);
+    }
+
+    if (wisdom[0] != '\0' && spectrum_wisdom_save(wisdom) != 0)
+        fprintf(stderr, "WARNING: could not save FFTW wisdom to '%s'\n", wisdom);
+
     // destroy objects
+    startup_destroy(&su);
+    realtime_destroy(&rt);
+    tonebank_destroy(&bank);
+    occupancy_destroy(&occ);
+    spectrum_destroy(&spec);
+    free (psd);
+    iqarc_writer_destroy(&arc);
     normalizer_destroy(&norm);
-    msresamp_crcf_destroy(resamp);
-    windowcf_destroy(log);
-    asgramcf_destroy(q);
+    sdr_channel_destroy(&chan);
+    if (log)
+        windowcf_destroy(log);
+    if (q)
+        asgramcf_destroy(q);
     timer_destroy(t1);
 
-    rtlsdr_close(dev);
+    sdr_source_destroy(&src);
+    if (fin && fin != stdin)
+        fclose(fin);
+    free (buffer_norm);
     free (buffer);
 
     return 0;
@@ -29,10 +29,17 @@
 #include <unistd.h>
 #include <assert.h>
 #include <sys/resource.h>
-#include <liquid/liquid.h>
 #include <rtl-sdr.h>
 
 #include "normalizer.h"
+#include "realtime.h"
+#include "timetag.h"
+#include "iqarc.h"
+#include "iq_output.h"
+#include "demod.h"
+#include "startup.h"
+#include "sdr_source.h"
+#include "sdr_channel.h"
 #include "debug.h"
 #include "convenience.h"
 
@@ -56,19 +63,37 @@ void usage() {
     printf("  s     : samplerate,            default: 2048000 Hz)]\n");
     printf("  r     : FFT rate [Hz],         default:   10 Hz\n");
     printf("  L     : output file log size,  default: 4096 samples\n");
-    printf("  F     : output filename,       default: 'asgram_rx.dat'\n");
+    printf("  O     : output format,         default: 'audio'\n");
+    printf("          audio : demodulated s16 audio at the channel rate\n");
+    printf("          cs16, cs8, cf32 : resampled I/Q at the channel rate\n");
+    printf("  M     : demodulator,           default: 'wbfm'\n");
+    printf("          am, nbfm, wbfm, usb, lsb\n");
+    printf("  k     : FM deviation or SSB bandwidth [Hz], default: 5k/75k, 2.8k\n");
+    printf("  c     : AM synchronous detection (carrier tracking)\n");
+    printf("  F     : output filename,       default: '-' (stdout)\n");
     printf("  d     : device_index,          default: 0\n");
+    printf("  m     : metadata filename,     default: none\n");
+    printf("          one line per output block: seq sample n rate mono_ns utc_ns gap\n");
+    printf("  I     : input filename,        default: none = device, '-' = stdin\n");
+    printf("          8-bit I/Q as written by rtl_sdr or rtl_siggen\n");
+    printf("  D     : remove DC offset and correct I/Q imbalance\n");
+    printf("  a     : digital AGC level [dBFS], default: off\n");
+    printf("  A     : archive filename,      default: none\n");
+    printf("          also record raw I/Q to a compressed chunked archive\n");
+    printf("  Q     : archive LSBs to drop,  default:  0 = lossless\n");
+    printf("  R     : real-time priority,    default:  0 = off\n");
+    printf("          SCHED_FIFO, locked memory, timing report on exit\n");
+    printf("  C     : CPU list to pin to,    default: none, e.g. '2' or '0,2-3'\n");
 }
 
 static int do_exit = 0;
-static uint32_t bytes_to_read = 0;
-static rtlsdr_dev_t *dev = NULL;
+static sdr_source_t *src = NULL;
 
 static void sighandler(int signum)
 {
     fprintf(stderr, "Signal caught, exiting!\n");
     do_exit = 1;
-    rtlsdr_cancel_async(dev);
+    sdr_source_cancel(src);
 }
 
 static int16_t to_int16(float f)
@@ -81,6 +106,10 @@ static int16_t to_int16(float f)
 // main program
 int main (int argc, char **argv)
 {
+    startup_t *su = startup_create();
+    int first = 1;
+    int last = 0;
+
     // command-line options
     int verbose = 1;
 
@@ -88,7 +117,7 @@ int main (int argc, char **argv)
     int gain = 0;
     float rx_resamp_rate;
     float bandwidth      = 800e3f;
-    int r, n_read;
+    int n_read;
 
     uint32_t frequency = 100000000;
     uint32_t samp_rate = DEFAULT_SAMPLE_RATE;
@@ -96,17 +125,44 @@ int main (int argc, char **argv)
     uint8_t *buffer;
     complex float *buffer_norm;
 
-    int dev_index = 0;
-    int dev_given = 0;
+    char *device = NULL;
+    char input[256] = "";
+    FILE *fin = NULL;
 
     struct sigaction sigact;
     normalizer_t *norm;
 
-    float kf = 0.1f;                    // modulation factor
+    int rt_priority = 0;
+    char *rt_cpus = NULL;
+    realtime_t *rt = NULL;
+
+    timetag_t *tt = NULL;
+    blockmeta_t meta, meta_out;
+
+    char *arc_filename = NULL;
+    unsigned int arc_shift = 0;
+    iqarc_writer_t *arc = NULL;
+
+    int dc_block = 0;
+    int agc_on = 0;
+    float agc_level = -10.0f;
+
+    demod_mode_t demod_mode = DEMOD_WBFM;
+    float demod_param = 0.0f;           // deviation / SSB bandwidth, 0 = default
+    int carrier_track = 0;
+    demod_t *dem = NULL;
+
+    int iq_mode = 0;                    // write I/Q instead of audio
+    iq_format_t iq_format = IQ_FORMAT_CS16;
+    iq_output_t *iq_out = NULL;
+    char filename[256]   = "-";
+    FILE *fid;
+    char *meta_filename = NULL;
+    FILE *meta_fid = NULL;
 
     //
     int d;
-    while ((d = getopt(argc,argv,"hf:b:B:G:p:s:")) != EOF) {
+    while ((d = getopt(argc,argv,"hf:b:B:G:p:s:d:O:F:R:C:I:A:Q:Da:m:M:k:c")) != EOF) {
             switch (d) {
                 case 'h':   usage();                    return 0;
                 case 'f':   frequency   = atof(optarg); break;
@@ -115,26 +171,71 @@ int main (int argc, char **argv)
                 case 'G':   gain = (int)(atof(optarg) * 10); break;
                 case 'p':   ppm_error = atoi(optarg); break;
                 case 's':   samp_rate = (uint32_t)atofs(optarg); break;
-                case 'd':
-                    dev_index = verbose_device_search(optarg);
-                    dev_given = 1;
+                case 'O':
+                    if (strcmp(optarg, "audio") == 0) {
+                        iq_mode = 0;
+                    } else if (iq_format_parse(optarg, &iq_format) == 0) {
+                        iq_mode = 1;
+                    } else {
+                        fprintf(stderr,"error: %s, unknown output format '%s'\n", argv[0], optarg);
+                        usage();
+                        return 1;
+                    }
+                    break;
+                case 'M':
+                    if (demod_mode_parse(optarg, &demod_mode) != 0) {
+                        fprintf(stderr,"error: %s, unknown demodulator '%s'\n", argv[0], optarg);
+                        usage();
+                        return 1;
+                    }
                     break;
+                case 'k':   demod_param = atof(optarg); break;
+                case 'c':   carrier_track = 1; break;
+                case 'F':   strncpy(filename,optarg,255); break;
+                case 'm':   meta_filename = optarg; break;
+                case 'I':   strncpy(input,optarg,255); break;
+                case 'D':   dc_block = 1; break;
+                case 'a':   agc_level = atof(optarg); agc_on = 1; break;
+                case 'A':   arc_filename = optarg; break;
+                case 'Q':   arc_shift = atoi(optarg); break;
+                case 'R':   rt_priority = atoi(optarg); break;
+                case 'C':   rt_cpus = optarg; break;
+                case 'd':   device = optarg; break;
                 default:    usage();                    return 1;
             }
     }
 
-    if (!dev_given) {
-            dev_index = verbose_device_search("0");
+    if (strcmp(filename, "-") == 0) {
+            fid = stdout;
+    } else {
+            fid = fopen(filename, "wb");
+            if (fid == NULL) {
+                    fprintf(stderr,"error: %s, could not open '%s' for writing\n", argv[0], filename);
+                    exit(1);
+            }
     }
 
-    if (dev_index < 0) {
-            exit(1);
+    if (meta_filename) {
+            meta_fid = fopen(meta_filename, "w");
+            if (meta_fid == NULL) {
+                    fprintf(stderr,"error: %s, could not open '%s' for writing\n", argv[0], meta_filename);
+                    exit(1);
+            }
+            fprintf(meta_fid, "# seq sample n rate mono_ns utc_ns gap\n");
     }
 
-    r = rtlsdr_open(&dev, (uint32_t)dev_index);
-    if (r < 0) {
-            fprintf(stderr, "Failed to open rtlsdr device #%d.\n", dev_index);
-            exit(1);
+    if (input[0] != '\0') {
+            // replay recorded (or rtl_siggen) samples instead of a device
+            fin = (strcmp(input, "-") == 0) ? stdin : fopen(input, "rb");
+            if (fin == NULL) {
+                    fprintf(stderr,"error: %s, could not open '%s' for reading\n", argv[0], input);
+                    exit(1);
+            }
+            src = sdr_source_file(fin, samp_rate);
+    } else {
+            src = sdr_source_device(device, samp_rate, frequency, gain, ppm_error);
+            if (src == NULL)
+                    exit(1);
     }
 
     sigact.sa_handler = sighandler;
@@ -145,38 +246,25 @@ int main (int argc, char **argv)
     sigaction(SIGQUIT, &sigact, NULL);
     sigaction(SIGPIPE, &sigact, NULL);
 
-    /* Set the sample rate */
-    verbose_set_sample_rate(dev, samp_rate);
-
-    /* Set the frequency */
-    verbose_set_frequency(dev, frequency);
-
-    if (0 == gain) {
-            /* Enable automatic gain */
-            verbose_auto_gain(dev);
-    } else {
-            /* Enable manual gain */
-            gain = nearest_gain(dev, gain);
-            verbose_gain_set(dev, gain);
-    }
-
-    verbose_ppm_set(dev, ppm_error);
+    startup_mark(su, "device");
 
     rx_resamp_rate = bandwidth/samp_rate;
 
-    printf("frequency       :   %10.4f [MHz]\n", frequency*1e-6f);
-    printf("bandwidth       :   %10.4f [kHz]\n", bandwidth*1e-3f);
-    printf("sample rate     :   %10.4f kHz = %10.4f kHz * %8.6f\n",
+    // status goes to stderr, stdout may carry the sample stream
+    fprintf(stderr, "frequency       :   %10.4f [MHz]\n", frequency*1e-6f);
+    fprintf(stderr, "bandwidth       :   %10.4f [kHz]\n", bandwidth*1e-3f);
+    fprintf(stderr, "sample rate     :   %10.4f kHz = %10.4f kHz * %8.6f\n",
            samp_rate * 1e-3f,
            bandwidth    * 1e-3f,
            1.0f / rx_resamp_rate);
-    printf("verbosity       :    %s\n", (verbose?"enabled":"disabled"));
+    fprintf(stderr, "output          :    %s\n", (iq_mode?"I/Q":demod_mode_name(demod_mode)));
+    fprintf(stderr, "verbosity       :    %s\n", (verbose?"enabled":"disabled"));
 
-    unsigned int i,j;
+    unsigned int j;
 
-    // add arbitrary resampling component
-    msresamp_crcf resamp = msresamp_crcf_create(rx_resamp_rate, 60.0f);
-    assert(resamp);
+    // arbitrary resampler (and AGC) down to the channel bandwidth
+    sdr_channel_t *chan = sdr_channel_create(samp_rate, bandwidth, out_block_size / 2);
+    startup_mark(su, "resampler");
 
     //allocate recv buffer
     buffer = malloc(out_block_size * sizeof(uint8_t));
@@ -186,69 +274,155 @@ int main (int argc, char **argv)
     assert(buffer_norm);
 
     // create buffer for arbitrary resamper output
-    int b_len = ((int)(out_block_size * rx_resamp_rate) + 64) >> 1;
+    int b_len = sdr_channel_max_out(chan);
     complex float buffer_resamp[b_len];
+    float buffer_audio[b_len];
     int16_t buffer_demod[b_len];
     debug("resamp_buffer_len: %d\n", b_len);
 
     norm = normalizer_create();
+    if (dc_block) {
+        normalizer_set_dc_block(norm, 0.05f);
+        normalizer_set_iq_correction(norm, 0.01f);
+    }
+    startup_mark(su, "normalizer");
+
+    if (agc_on)
+        sdr_channel_set_agc(chan, agc_level);
+
+    if (iq_mode) {
+        iq_out = iq_output_create(fid, iq_format, b_len);
+    } else {
+        dem = demod_create(demod_mode, sdr_channel_rate(chan), demod_param, b_len);
+        demod_set_carrier_tracking(dem, carrier_track);
+    }
+
+    if (arc_filename) {
+        arc = iqarc_writer_create(arc_filename, samp_rate, frequency, arc_shift);
+        if (arc == NULL) {
+            fprintf(stderr,"error: %s, could not create archive '%s'\n", argv[0], arc_filename);
+            exit(1);
+        }
+        // a file can wait for the encoder, a device cannot
+        if (fin)
+            iqarc_writer_set_blocking(arc, 1);
+    }
+
+    tt = sdr_source_timetag(src);
 
-    verbose_reset_buffer(dev);
+    // after all buffers are allocated, so they get locked and prefaulted
+    if (rt_priority > 0)
+        rt = realtime_create(rt_priority, rt_cpus,
+                             (out_block_size / 2) / (double)samp_rate);
 
-    freqdem dem = freqdem_create(kf);
+    sdr_source_start(src);
 
     while (!do_exit) {
-            // grab data from device
-            r = rtlsdr_read_sync(dev, buffer, out_block_size, &n_read);
-            if (r < 0) {
+            // grab tagged block from device or file
+            n_read = sdr_source_read(src, buffer, out_block_size / 2, &meta);
+            if (n_read < 0) {
                     fprintf(stderr, "WARNING: sync read failed.\n");
                     break;
             }
+            if (n_read == 0)
+                    break;
 
-            if ((bytes_to_read > 0) && (bytes_to_read < (uint32_t)n_read)) {
-                    n_read = bytes_to_read;
-                    do_exit = 1;
+            if (first) {
+                startup_mark(su, "first block");
+                startup_report(su, stderr);
+                first = 0;
             }
 
-            // push data through arbitrary resampler and give to frame synchronizer
-            // TODO : apply bandwidth-dependent gain
-            for (i=0; i<n_read/2; i++) {
-                    // grab sample from usrp buffer
-                    buffer_norm[i] = normalizer_normalize(norm, *((uint16_t*)buffer+i));
+            if (rt)
+                realtime_block_begin(rt);
+
+            if (meta.gap > 0)
+                fprintf(stderr, "WARNING: %llu samples lost, detected at block %llu\n",
+                        (unsigned long long)meta.gap, (unsigned long long)meta.seq);
+
+            // hand raw block to the archive encoder thread
+            if (arc)
+                iqarc_writer_write(arc, buffer, n_read, &meta);
+
+            // convert (with optional DC/IQ correction) and push whole
+            // block through arbitrary resampler
+            normalizer_convert(norm, buffer, buffer_norm, n_read);
+
+            // audio and I/Q output run at the resampler rate
+            unsigned int nw = sdr_channel_execute(chan, buffer_norm, n_read, &meta,
+                                                  buffer_resamp, &meta_out);
+            if (meta_fid)
+                blockmeta_print(&meta_out, meta_fid);
+
+            if (iq_mode) {
+                    if (iq_output_write(iq_out, buffer_resamp, nw) != 0) {
+                            fprintf(stderr, "Short write, samples lost, exiting!\n");
+                            last = 1;
+                    }
+            } else {
+                    demod_execute(dem, buffer_resamp, nw, buffer_audio);
+                    for(j=0;j<nw;j++)
+                        buffer_demod[j] = to_int16(buffer_audio[j]);
+
+                    if (fwrite(buffer_demod, 2, nw, fid) != (size_t)nw) {
+                            fprintf(stderr, "Short write, samples lost, exiting!\n");
+                            last = 1;
+                    }
             }
-            // push through resampler (one at a time)
-            unsigned int nw;
-            float demod;
-            msresamp_crcf_execute(resamp, buffer_norm, n_read/2, buffer_resamp, &nw);
 
-            for(j=0;j<nw;j++)
-                {
-                    freqdem_demodulate(dem, buffer_resamp[j], &demod);
-                    buffer_demod[j] = to_int16(demod);
+            if ((uint32_t)n_read < out_block_size / 2) {
+                    if (fin == NULL)
+                            fprintf(stderr, "Short read, samples lost, exiting!\n");
+                    last = 1;
+            }
 
-                }
+            // close the block's deadline accounting before leaving
+            if (rt)
+                realtime_block_end(rt);
+            if (last)
+                break;
 
-            if (fwrite(buffer_demod, 2, nw, stdout) != (size_t)nw) {
-                    fprintf(stderr, "Short write, samples lost, exiting!\n");
-                    break;
-            }
+    }
 
-            if ((uint32_t)n_read < out_block_size) {
-                    fprintf(stderr, "Short read, samples lost, exiting!\n");
-                    break;
-            }
+    if (iq_out && iq_output_clipped(iq_out) > 0)
+            fprintf(stderr, "I/Q output clipped %llu times\n",
+                    (unsigned long long)iq_output_clipped(iq_out));
+
+    if (rt)
+        realtime_report(rt, stderr);
+
+    if (timetag_lost(tt) > 0)
+        fprintf(stderr, "samples lost    :   %llu\n", (unsigned long long)timetag_lost(tt));
 
-            if (bytes_to_read > 0)
-                bytes_to_read -= n_read;
+    if (arc) {
+        uint64_t arc_samples, arc_bytes, arc_dropped;
 
+        if (iqarc_writer_close(arc) != 0)
+            fprintf(stderr, "WARNING: error writing archive '%s'\n", arc_filename);
+        iqarc_writer_stats(arc, &arc_samples, &arc_bytes, &arc_dropped);
+        fprintf(stderr, "archive         :   %llu samples, %llu bytes (%5.1f%%), %llu dropped\n",
+                (unsigned long long)arc_samples, (unsigned long long)arc_bytes,
+                arc_samples ? 100.0 * arc_bytes / (2.0 * arc_samples) : 0.0,
+                (unsigned long long)arc_dropped);
     }
 
     // destroy objects
-    freqdem_destroy(dem);
+    startup_destroy(&su);
+    realtime_destroy(&rt);
+    iqarc_writer_destroy(&arc);
+    iq_output_destroy(&iq_out);
+    if (fid != stdout)
+            fclose(fid);
+    if (meta_fid)
+            fclose(meta_fid);
+    demod_destroy(&dem);
     normalizer_destroy(&norm);
-    msresamp_crcf_destroy(resamp);
+    sdr_channel_destroy(&chan);
 
-    rtlsdr_close(dev);
+    sdr_source_destroy(&src);
+    if (fin && fin != stdin)
+        fclose(fin);
+    free (buffer_norm);
     free (buffer);
 
     return 0;
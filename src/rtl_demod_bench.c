@@ -0,0 +1,136 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <liquid/liquid.h>
+
+#include "siggen.h"
+#include "demod.h"
+#include "debug.h"
+
+#define DEFAULT_SAMPLE_RATE		240000
+#define DEFAULT_BUF_LENGTH		(8 * 1024)
+
+void usage() {
+    printf("Usage: rtl_demod_bench [OPTION]\n");
+    printf("Measure demodulator throughput on synthetic samples\n");
+    printf("\n");
+    printf("  h     : help\n");
+    printf("  s     : channel samplerate,    default: 240000 Hz\n");
+    printf("  T     : signal duration [s],   default: 60 s\n");
+    printf("  B     : block size [samples],  default: 8192\n");
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *name, unsigned int n, double t, uint32_t samp_rate)
+{
+    printf("%-16s:   %10.2f Msps  (%7.1fx real time)\n",
+           name, n / t * 1e-6, n / t / samp_rate);
+}
+
+// main program
+int main (int argc, char **argv)
+{
+    uint32_t samp_rate = DEFAULT_SAMPLE_RATE;
+    unsigned int block = DEFAULT_BUF_LENGTH;
+    float duration = 60.0f;
+    unsigned int n, i, j;
+    complex float *x;
+    float *y;
+    double t;
+
+    static const struct { demod_mode_t mode; int track; const char *name; } modes[] = {
+        { DEMOD_NBFM, 0, "nbfm" },
+        { DEMOD_WBFM, 0, "wbfm" },
+        { DEMOD_AM,   0, "am" },
+        { DEMOD_AM,   1, "am (sync)" },
+        { DEMOD_USB,  0, "usb" },
+        { DEMOD_LSB,  0, "lsb" },
+    };
+
+    //
+    int d;
+    while ((d = getopt(argc,argv,"hs:T:B:")) != EOF) {
+            switch (d) {
+                case 'h':   usage();                    return 0;
+                case 's':   samp_rate = (uint32_t)atof(optarg); break;
+                case 'T':   duration = atof(optarg); break;
+                case 'B':   block = (unsigned int)atof(optarg); break;
+                default:    usage();                    return 1;
+            }
+    }
+
+    n = (unsigned int)(duration * samp_rate) / block * block;
+    if (n == 0) {
+            fprintf(stderr,"error: %s, duration shorter than one block\n", argv[0]);
+            return 1;
+    }
+
+    // FM tone on the carrier, it exercises every mode
+    x = malloc(n * sizeof(complex float));
+    y = malloc(block * sizeof(float));
+    assert(x && y);
+
+    siggen_t *gen = siggen_create(samp_rate, 1);
+    siggen_add_fm_tone(gen, 0.0f, 0.5f, 1000.0f, 5000.0f);
+    siggen_set_snr(gen, 30.0f);
+    siggen_generate(gen, x, n);
+    siggen_destroy(&gen);
+
+    printf("samples         :   %u in blocks of %u at %u Hz\n", n, block, samp_rate);
+
+    // per-sample liquid-dsp discriminator, as rtl_demod used to run it
+    freqdem fdem = freqdem_create(5000.0f / samp_rate);
+    t = now();
+    for (i = 0; i < n; i += block)
+        for (j = 0; j < block; j++)
+            freqdem_demodulate(fdem, x[i + j], &y[j]);
+    report("freqdem", n, now() - t, samp_rate);
+    freqdem_destroy(fdem);
+
+    for (j = 0; j < sizeof(modes) / sizeof(modes[0]); j++) {
+            demod_t *dem = demod_create(modes[j].mode, samp_rate, 0.0f, block);
+            demod_set_carrier_tracking(dem, modes[j].track);
+
+            t = now();
+            for (i = 0; i < n; i += block)
+                demod_execute(dem, &x[i], block, y);
+            report(modes[j].name, n, now() - t, samp_rate);
+
+            demod_destroy(&dem);
+    }
+
+    free (y);
+    free (x);
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*  =========================================================================
+    rtl_iqarc - list and extract compressed I/Q archives
+
+    -------------------------------------------------------------------------
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "timetag.h"
+#include "iqarc.h"
+#include "debug.h"
+
+void usage() {
+    printf("Usage: rtl_iqarc [OPTION] ARCHIVE\n");
+    printf("List or extract 8-bit I/Q from an archive written with -A\n");
+    printf("\n");
+    printf("  h     : help\n");
+    printf("  l     : list chunk index\n");
+    printf("  t     : start [s] from beginning of recording, default: 0\n");
+    printf("  T     : duration [s],          default: 0 = to the end\n");
+    printf("  F     : output filename,       default: '-' (stdout)\n");
+    printf("  g     : fill capture gaps with zero-level samples, default: off\n");
+    printf("\n");
+    printf("Capture gaps inside the extracted range are reported on stderr\n");
+    printf("with their position in the output.\n");
+}
+
+// main program
+int main (int argc, char **argv)
+{
+    int list = 0;
+    double start = 0.0;
+    double duration = 0.0;
+    int fill = 0;
+    char filename[256] = "-";
+    FILE *fid;
+
+    //
+    int d;
+    while ((d = getopt(argc,argv,"hlt:T:F:g")) != EOF) {
+            switch (d) {
+                case 'h':   usage();                    return 0;
+                case 'l':   list = 1; break;
+                case 't':   start = atof(optarg); break;
+                case 'T':   duration = atof(optarg); break;
+                case 'F':   strncpy(filename,optarg,255); break;
+                case 'g':   fill = 1; break;
+                default:    usage();                    return 1;
+            }
+    }
+
+    if (optind >= argc) {
+            usage();
+            return 1;
+    }
+
+    iqarc_reader_t *arc = iqarc_reader_open(argv[optind]);
+    if (arc == NULL) {
+            fprintf(stderr,"error: %s, could not open archive '%s'\n", argv[0], argv[optind]);
+            return 1;
+    }
+
+    const iqarc_info_t *info = iqarc_reader_info(arc);
+    const iqarc_index_t *index;
+    unsigned int i, n_chunks = iqarc_reader_index(arc, &index);
+
+    if (list) {
+            printf("frequency       :   %10.4f [MHz]\n", info->frequency*1e-6);
+            printf("sample rate     :   %10.4f [kHz]\n", info->samp_rate*1e-3);
+            printf("dropped LSBs    :   %u\n", info->shift);
+            printf("chunks          :   %u\n", n_chunks);
+            for (i = 0; i < n_chunks; i++) {
+                    char utc[32];
+
+                    timetag_format_utc(index[i].timestamp, utc, sizeof(utc));
+                    printf("%8u %12llu %10u %s\n", i,
+                           (unsigned long long)index[i].sample_offset,
+                           index[i].n_samples, utc);
+            }
+            iqarc_reader_destroy(&arc);
+            return 0;
+    }
+
+    if (n_chunks == 0) {
+            iqarc_reader_destroy(&arc);
+            return 0;
+    }
+
+    if (strcmp(filename, "-") == 0) {
+            fid = stdout;
+    } else {
+            fid = fopen(filename, "wb");
+            if (fid == NULL) {
+                    fprintf(stderr,"error: %s, could not open '%s' for writing\n", argv[0], filename);
+                    return 1;
+            }
+    }
+
+    // locate first chunk via the index, then trim each chunk to the
+    // requested time range on its own timestamp, so a range starting or
+    // ending in a capture gap is cut at the right samples
+    uint64_t t0 = index[0].timestamp + (uint64_t)(start * 1e9);
+    uint64_t t1 = (duration > 0.0) ? t0 + (uint64_t)(duration * 1e9) : UINT64_MAX;
+    uint64_t next = 0, written = 0;
+    int k = iqarc_reader_seek(arc, t0);
+
+    uint8_t *buffer = malloc(2 * info->chunk_samples);
+    assert(buffer);
+
+    while (k >= 0) {
+            iqarc_index_t chunk;
+            uint64_t begin = 0, end;
+
+            int n = iqarc_reader_read(arc, buffer, &chunk);
+            if (n < 0) {
+                    fprintf(stderr, "WARNING: corrupt chunk, stopping\n");
+                    break;
+            }
+            if (n == 0 || chunk.timestamp >= t1)
+                    break;
+
+            if (t0 > chunk.timestamp)
+                    begin = (t0 - chunk.timestamp) * info->samp_rate / 1000000000ULL;
+            end = (t1 == UINT64_MAX) ? (uint64_t)n :
+                    (t1 - chunk.timestamp) * info->samp_rate / 1000000000ULL;
+            if (end > (uint64_t)n)
+                    end = n;
+            if (begin >= end)
+                    continue;
+
+            // chunks are contiguous unless the capture lost samples
+            if (written > 0 && chunk.sample_offset + begin > next) {
+                    uint64_t gap = chunk.sample_offset + begin - next;
+                    char utc[32];
+
+                    timetag_format_utc(chunk.timestamp, utc, sizeof(utc));
+                    fprintf(stderr, "gap of %llu samples before %s, at output sample %llu%s\n",
+                            (unsigned long long)gap, utc, (unsigned long long)written,
+                            fill ? ", filled" : "");
+                    if (fill) {
+                            static const uint8_t zero[2] = { 127, 127 };
+
+                            for (; gap > 0; gap--, written++)
+                                    if (fwrite(zero, 2, 1, fid) != 1)
+                                            break;
+                            if (gap > 0) {
+                                    fprintf(stderr, "Short write, exiting!\n");
+                                    break;
+                            }
+                    }
+            }
+
+            if (fwrite(buffer + 2 * begin, 2, end - begin, fid) != end - begin) {
+                    fprintf(stderr, "Short write, exiting!\n");
+                    break;
+            }
+            written += end - begin;
+            next = chunk.sample_offset + end;
+    }
+
+    if (fid != stdout)
+            fclose(fid);
+    free(buffer);
+    iqarc_reader_destroy(&arc);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*  =========================================================================
+    rtl_occupancy - query spectrum occupancy stores written by rtl_asgram
+
+    -------------------------------------------------------------------------
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <string.h>
+#include <time.h>
+
+#include "occupancy.h"
+#include "debug.h"
+
+void usage() {
+    printf("Usage: rtl_occupancy [OPTION] STORE\n");
+    printf("Print per-bin statistics from an occupancy store (rtl_asgram -U)\n");
+    printf("\n");
+    printf("  h     : help\n");
+    printf("  H     : last hours to include, default: 0 = all\n");
+    printf("  p     : percentile,            default: 90\n");
+}
+
+// main program
+int main (int argc, char **argv)
+{
+    float hours = 0.0f;
+    float pct = 90.0f;
+    unsigned int i;
+
+    //
+    int d;
+    while ((d = getopt(argc,argv,"hH:p:")) != EOF) {
+            switch (d) {
+                case 'h':   usage();                    return 0;
+                case 'H':   hours = atof(optarg); break;
+                case 'p':   pct = atof(optarg); break;
+                default:    usage();                    return 1;
+            }
+    }
+
+    if (optind >= argc) {
+            usage();
+            return 1;
+    }
+
+    // read-only mapping, safe while rtl_asgram keeps updating it
+    occupancy_t *occ = occupancy_open(argv[optind]);
+    if (occ == NULL) {
+            fprintf(stderr,"error: %s, could not open store '%s'\n", argv[0], argv[optind]);
+            return 1;
+    }
+
+    const occupancy_info_t *info = occupancy_info(occ);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t to = now.tv_sec * 1000000000ULL + now.tv_nsec;
+    uint64_t from = (hours > 0.0f) ? to - (uint64_t)(hours * 3600e9) : 0;
+
+    printf("# frequency       :   %10.4f [MHz]\n", info->frequency*1e-6);
+    printf("# bandwidth       :   %10.4f [kHz]\n", info->bandwidth*1e-3);
+    printf("# busy level      :   %10.1f [dB]\n", info->threshold);
+    printf("# %12s %10s %7s %7s %7s %7s %7s\n",
+           "freq [MHz]", "frames", "min", "mean", "p", "max", "duty");
+
+    for (i = 0; i < info->nbins; i++) {
+            occupancy_stats_t st;
+            double f = info->frequency +
+                       ((double)i - info->nbins / 2) * info->bandwidth / info->nbins;
+
+            int rc = occupancy_query(occ, from, UINT64_MAX, i, pct, &st);
+            if (rc == -2) {
+                    fprintf(stderr,"error: %s, store '%s' stays busy (writer stopped mid-update?)\n",
+                            argv[0], argv[optind]);
+                    occupancy_destroy(&occ);
+                    return 1;
+            }
+            if (rc != 0)
+                    continue;
+            printf("  %12.6f %10llu %7.1f %7.1f %7.1f %7.1f %6.2f%%\n",
+                   f*1e-6, (unsigned long long)st.frames, st.min, st.mean,
+                   st.percentile, st.max, 100.0f * st.duty);
+    }
+
+    occupancy_destroy(&occ);
+
+    return 0;
+}
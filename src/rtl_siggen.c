@@ -0,0 +1,163 @@
+/*  =========================================================================
+    rtl_siggen - deterministic synthetic rtl-sdr sample source
+
+    -------------------------------------------------------------------------
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <string.h>
+#include <assert.h>
+
+#include "siggen.h"
+#include "debug.h"
+
+#define DEFAULT_SAMPLE_RATE		2048000
+#define DEFAULT_BUF_LENGTH		(16 * 1024)
+
+void usage() {
+    printf("Usage: rtl_siggen [OPTION]\n");
+    printf("Write synthetic 8-bit I/Q samples in rtl-sdr format\n");
+    printf("\n");
+    printf("  h     : help\n");
+    printf("  s     : samplerate,            default: 2048000 Hz\n");
+    printf("  T     : duration [s],          default: 1 s\n");
+    printf("  t     : FM tone 'offset:amplitude:tone:deviation' [Hz], repeatable\n");
+    printf("  c     : carrier 'offset:amplitude' [Hz], repeatable\n");
+    printf("  u     : burst 'offset:amplitude:on:period' [Hz, s], repeatable\n");
+    printf("  N     : SNR [dB],              default: no noise\n");
+    printf("  S     : seed,                  default: 1\n");
+    printf("  F     : output filename,       default: '-' (stdout)\n");
+}
+
+// main program
+int main (int argc, char **argv)
+{
+    uint32_t samp_rate = DEFAULT_SAMPLE_RATE;
+    uint32_t seed = 1;
+    float duration = 1.0f;
+    float snr_db = 0.0f;
+    int noise = 0;
+    char filename[256] = "-";
+    FILE *fid;
+
+    float p[4];
+    int n_tones = 0, n_carriers = 0, n_bursts = 0;
+    struct { float p[4]; } tones[SIGGEN_MAX_SOURCES],
+                           carriers[SIGGEN_MAX_SOURCES],
+                           bursts[SIGGEN_MAX_SOURCES];
+
+    //
+    int d;
+    while ((d = getopt(argc,argv,"hs:T:t:c:u:N:S:F:")) != EOF) {
+            switch (d) {
+                case 'h':   usage();                    return 0;
+                case 's':   samp_rate = (uint32_t)atof(optarg); break;
+                case 'T':   duration = atof(optarg); break;
+                case 't':
+                    if (n_tones == SIGGEN_MAX_SOURCES ||
+                        sscanf(optarg, "%f:%f:%f:%f", &p[0], &p[1], &p[2], &p[3]) != 4) {
+                        fprintf(stderr,"error: %s, invalid tone '%s'\n", argv[0], optarg);
+                        return 1;
+                    }
+                    memcpy(tones[n_tones++].p, p, sizeof(p));
+                    break;
+                case 'c':
+                    if (n_carriers == SIGGEN_MAX_SOURCES ||
+                        sscanf(optarg, "%f:%f", &p[0], &p[1]) != 2) {
+                        fprintf(stderr,"error: %s, invalid carrier '%s'\n", argv[0], optarg);
+                        return 1;
+                    }
+                    memcpy(carriers[n_carriers++].p, p, sizeof(p));
+                    break;
+                case 'u':
+                    if (n_bursts == SIGGEN_MAX_SOURCES ||
+                        sscanf(optarg, "%f:%f:%f:%f", &p[0], &p[1], &p[2], &p[3]) != 4) {
+                        fprintf(stderr,"error: %s, invalid burst '%s'\n", argv[0], optarg);
+                        return 1;
+                    }
+                    memcpy(bursts[n_bursts++].p, p, sizeof(p));
+                    break;
+                case 'N':   snr_db = atof(optarg); noise = 1; break;
+                case 'S':   seed = (uint32_t)atol(optarg); break;
+                case 'F':   strncpy(filename,optarg,255); break;
+                default:    usage();                    return 1;
+            }
+    }
+
+    siggen_t *gen = siggen_create(samp_rate, seed);
+    int i, ok = 1;
+
+    for (i = 0; i < n_tones; i++)
+        ok &= siggen_add_fm_tone(gen, tones[i].p[0], tones[i].p[1],
+                                 tones[i].p[2], tones[i].p[3]) == 0;
+    for (i = 0; i < n_carriers; i++)
+        ok &= siggen_add_fm_tone(gen, carriers[i].p[0], carriers[i].p[1],
+                                 0.0f, 0.0f) == 0;
+    for (i = 0; i < n_bursts; i++)
+        ok &= siggen_add_burst(gen, bursts[i].p[0], bursts[i].p[1],
+                               bursts[i].p[2], bursts[i].p[3]) == 0;
+    if (!ok) {
+        fprintf(stderr,"error: %s, at most %d sources\n", argv[0], SIGGEN_MAX_SOURCES);
+        return 1;
+    }
+    if (noise)
+        siggen_set_snr(gen, snr_db);
+
+    if (strcmp(filename, "-") == 0) {
+        fid = stdout;
+    } else {
+        fid = fopen(filename, "wb");
+        if (fid == NULL) {
+            fprintf(stderr,"error: %s, could not open '%s' for writing\n", argv[0], filename);
+            return 1;
+        }
+    }
+
+    complex float *buffer = malloc(DEFAULT_BUF_LENGTH * sizeof(complex float));
+    uint8_t *buffer_cu8 = malloc(2 * DEFAULT_BUF_LENGTH);
+    assert(buffer && buffer_cu8);
+
+    uint64_t remaining = (uint64_t)(duration * samp_rate);
+    uint64_t clipped = 0;
+    while (remaining > 0) {
+        unsigned int n = remaining < DEFAULT_BUF_LENGTH ? remaining : DEFAULT_BUF_LENGTH;
+
+        siggen_generate(gen, buffer, n);
+        clipped += siggen_to_cu8(buffer, buffer_cu8, n);
+        if (fwrite(buffer_cu8, 2, n, fid) != n) {
+            fprintf(stderr, "Short write, exiting!\n");
+            break;
+        }
+        remaining -= n;
+    }
+
+    if (clipped > 0)
+        fprintf(stderr, "WARNING: %llu components clipped\n", (unsigned long long)clipped);
+
+    if (fid != stdout)
+        fclose(fid);
+    free(buffer_cu8);
+    free(buffer);
+    siggen_destroy(&gen);
+
+    return 0;
+}
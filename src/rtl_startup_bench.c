@@ -0,0 +1,266 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/wait.h>
+#include <liquid/liquid.h>
+
+#include "normalizer.h"
+#include "spectrum.h"
+#include "debug.h"
+
+#define DEFAULT_SAMPLE_RATE		2048000
+#define DEFAULT_BANDWIDTH		800e3f
+#define DEFAULT_FFT_SIZE		1024
+#define DEFAULT_RUNS			15
+#define MAX_RUNS			101
+#define BLOCK_SAMPLES			16384	// first block converted by the lut phases
+
+void usage() {
+    printf("Usage: rtl_startup_bench [OPTION]\n");
+    printf("Measure startup phases, each run in a fresh process\n");
+    printf("\n");
+    printf("  h     : help\n");
+    printf("  s     : samplerate,            default: 2048000 Hz\n");
+    printf("  b     : bandwidth [Hz],        default: 800 kHz\n");
+    printf("  n     : FFT size,              default: 1024\n");
+    printf("  r     : runs per phase,        default: 15\n");
+    printf("  W     : FFTW wisdom directory, default: new one in /tmp, removed on exit\n");
+}
+
+static uint32_t samp_rate = DEFAULT_SAMPLE_RATE;
+static float bandwidth = DEFAULT_BANDWIDTH;
+static unsigned int nfft = DEFAULT_FFT_SIZE;
+static char wisdom[512];
+static uint8_t block[2 * BLOCK_SAMPLES];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// normalizer table as it was computed at runtime before gen_lut. Both
+// lut phases include converting the first block: the generated table
+// costs nothing to create, its page faults come on first use instead.
+static double lut_runtime(void)
+{
+    const uint16_t *idx = (const uint16_t *) block;
+    float complex *y = malloc(BLOCK_SAMPLES * sizeof(float complex));
+    double t = now();
+    unsigned int i;
+    float complex *lut = malloc(0x10000 * sizeof(float complex));
+    assert(lut && y);
+
+    for (i = 0; i < 0x10000; i++)
+        lut[i] = (((float)(i & 0xff) - 127.4f) * (1.0f/128.0f)) +
+                 _Complex_I * (((float)(i >> 8) - 127.4f) * (1.0f/128.0f));
+    for (i = 0; i < BLOCK_SAMPLES; i++)
+        y[i] = lut[idx[i]];
+    t = now() - t;
+
+    volatile float sink = crealf(y[1234]);
+    (void)sink;
+    free(lut);
+    free(y);
+    return t;
+}
+
+static double lut_generated(void)
+{
+    float complex *y = malloc(BLOCK_SAMPLES * sizeof(float complex));
+    assert(y);
+    double t = now();
+    normalizer_t *norm = normalizer_create();
+    normalizer_convert(norm, block, y, BLOCK_SAMPLES);
+    t = now() - t;
+
+    volatile float sink = crealf(y[1234]);
+    (void)sink;
+    normalizer_destroy(&norm);
+    free(y);
+    return t;
+}
+
+static double fft_estimate(void)
+{
+    double t = now();
+    spectrum_t *spec = spectrum_create(nfft);
+    t = now() - t;
+
+    spectrum_destroy(&spec);
+    return t;
+}
+
+// measured plan, with whatever wisdom file is (or is not) there;
+// the load is part of the cost
+static double fft_measure(void)
+{
+    double t = now();
+    if (spectrum_wisdom_load(wisdom) != 0)
+        spectrum_wisdom_measure();
+    spectrum_t *spec = spectrum_create(nfft);
+    t = now() - t;
+
+    spectrum_wisdom_save(wisdom);
+    spectrum_destroy(&spec);
+    return t;
+}
+
+static double resampler(void)
+{
+    double t = now();
+    msresamp_crcf q = msresamp_crcf_create(bandwidth / samp_rate, 60.0f);
+    t = now() - t;
+
+    msresamp_crcf_destroy(q);
+    return t;
+}
+
+// run phase in a child process, so no table, page or FFTW planner state
+// survives from the previous run
+static double run(double (*phase)(void))
+{
+    int fd[2];
+    double t = -1.0;
+    pid_t pid;
+
+    if (pipe(fd) != 0)
+        return -1.0;
+
+    pid = fork();
+    if (pid == 0) {
+        t = phase();
+        if (write(fd[1], &t, sizeof(t)) != sizeof(t))
+            _exit(1);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    if (pid < 0 || read(fd[0], &t, sizeof(t)) != sizeof(t))
+        t = -1.0;
+    close(fd[0]);
+    if (pid > 0)
+        waitpid(pid, NULL, 0);
+
+    return t;
+}
+
+static int cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// median, min and max over runs; 'cold' removes the wisdom file first
+static int bench(const char *name, double (*phase)(void), unsigned int runs, int cold)
+{
+    double t[MAX_RUNS];
+    unsigned int i;
+
+    for (i = 0; i < runs; i++) {
+            if (cold)
+                unlink(wisdom);
+            t[i] = run(phase);
+            if (t[i] < 0.0) {
+                fprintf(stderr, "error: %s, run failed\n", name);
+                return -1;
+            }
+    }
+    qsort(t, runs, sizeof(double), cmp);
+
+    printf("%-16s:   %10.3f [ms] (min %.3f, max %.3f)\n",
+           name, t[runs / 2] * 1e3, t[0] * 1e3, t[runs - 1] * 1e3);
+    return 0;
+}
+
+// main program
+int main (int argc, char **argv)
+{
+    unsigned int runs = DEFAULT_RUNS;
+    char *wisdom_dir = NULL;
+    char tmp_dir[] = "/tmp/rtl_startup_bench.XXXXXX";
+    int err = 0;
+
+    //
+    int d;
+    while ((d = getopt(argc,argv,"hs:b:n:r:W:")) != EOF) {
+            switch (d) {
+                case 'h':   usage();                    return 0;
+                case 's':   samp_rate = (uint32_t)atof(optarg); break;
+                case 'b':   bandwidth = atof(optarg); break;
+                case 'n':   nfft = atoi(optarg); break;
+                case 'r':   runs = atoi(optarg); break;
+                case 'W':   wisdom_dir = optarg; break;
+                default:    usage();                    return 1;
+            }
+    }
+
+    if (runs < 1 || runs > MAX_RUNS) {
+            fprintf(stderr,"error: %s, runs must be in [1, %u]\n", argv[0], MAX_RUNS);
+            return 1;
+    }
+    if (nfft < 2 || bandwidth <= 0.0f || bandwidth > samp_rate) {
+            fprintf(stderr,"error: %s, need FFT size >= 2 and 0 < bandwidth <= samplerate\n", argv[0]);
+            return 1;
+    }
+
+    // throw-away wisdom unless asked otherwise, so the cold runs are cold
+    if (wisdom_dir == NULL) {
+            if (mkdtemp(tmp_dir) == NULL) {
+                fprintf(stderr,"error: %s, could not create '%s'\n", argv[0], tmp_dir);
+                return 1;
+            }
+    }
+    snprintf(wisdom, sizeof(wisdom), "%s/fftwf_wisdom", wisdom_dir ? wisdom_dir : tmp_dir);
+
+    printf("runs            :   %u per phase, median (min, max)\n", runs);
+    printf("FFT size        :   %u\n", nfft);
+    printf("resampler       :   %u Hz -> %.0f Hz\n", samp_rate, bandwidth);
+
+    // noise-like bytes, so the first block touches the whole table
+    srand(1);
+    for (unsigned int i = 0; i < sizeof(block); i++)
+        block[i] = (uint8_t) rand();
+
+    // before and after the build-time table, FFTW_ESTIMATE and
+    // FFTW_MEASURE without and with a wisdom file
+    err |= bench("lut (runtime)", lut_runtime, runs, 0);
+    err |= bench("lut (generated)", lut_generated, runs, 0);
+    err |= bench("fft estimate", fft_estimate, runs, 0);
+    err |= bench("fft measure", fft_measure, runs, 1);
+    err |= bench("fft wisdom", fft_measure, runs, 0);
+    err |= bench("resampler", resampler, runs, 0);
+
+    if (wisdom_dir == NULL) {
+            unlink(wisdom);
+            rmdir(tmp_dir);
+    }
+
+    return err ? 1 : 0;
+}
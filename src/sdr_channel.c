@@ -0,0 +1,125 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <liquid/liquid.h>
+
+#include "debug.h"
+#include "timetag.h"
+#include "blockagc.h"
+#include "sdr_channel.h"
+
+struct _sdr_channel_t {
+	msresamp_crcf resamp;
+	float rate;		//  output rate [Hz]
+	unsigned int max_in;
+	unsigned int max_out;
+	blockagc_t *agc;	//  NULL = off
+	timetag_map_t map;	//  capture tags to output tags
+};
+
+sdr_channel_t *
+sdr_channel_create (uint32_t in_rate, float bandwidth, unsigned int max_in)
+{
+	float ratio = bandwidth / in_rate;
+
+	sdr_channel_t *self = (sdr_channel_t *) malloc (sizeof (sdr_channel_t));
+	assert(self);
+
+	self->resamp = msresamp_crcf_create(ratio, 60.0f);
+	assert(self->resamp);
+	self->rate = in_rate * ratio;
+	self->max_in = max_in;
+	self->max_out = (unsigned int)(max_in * ratio) + 32;
+	self->agc = NULL;
+	timetag_map_init(&self->map, in_rate, self->rate,
+			msresamp_crcf_get_delay(self->resamp));
+
+	debug("channel: %u -> %.1f Hz, max_out %u", in_rate, self->rate, self->max_out);
+
+	return self;
+}
+
+void
+sdr_channel_set_agc (sdr_channel_t *self, float level)
+{
+	assert(self);
+
+	//  after resampling, so the gain follows the in-band signal
+	//  rather than the whole captured band
+	blockagc_destroy(&self->agc);
+	self->agc = blockagc_create(level, 0.1f, 60.0f);
+}
+
+float
+sdr_channel_rate (sdr_channel_t *self)
+{
+	assert(self);
+	return self->rate;
+}
+
+unsigned int
+sdr_channel_max_out (sdr_channel_t *self)
+{
+	assert(self);
+	return self->max_out;
+}
+
+unsigned int
+sdr_channel_execute (sdr_channel_t *self, const complex float *x,
+		unsigned int n, const blockmeta_t *meta,
+		complex float *y, blockmeta_t *meta_out)
+{
+	unsigned int nw;
+
+	assert(self);
+	assert(n <= self->max_in);
+
+	msresamp_crcf_execute(self->resamp, (complex float *) x, n, y, &nw);
+
+	if (self->agc)
+		blockagc_execute(self->agc, y, nw);
+
+	if (meta) {
+		blockmeta_t unused;
+		timetag_output(&self->map, meta, nw, meta_out ? meta_out : &unused);
+	}
+
+	return nw;
+}
+
+void
+sdr_channel_destroy (sdr_channel_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		sdr_channel_t *self = *self_p;
+
+		msresamp_crcf_destroy(self->resamp);
+		blockagc_destroy(&self->agc);
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
@@ -0,0 +1,166 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <signal.h>
+#include <rtl-sdr.h>
+
+#include "debug.h"
+#include "timetag.h"
+#include "sdr_source.h"
+#include "convenience.h"
+
+struct _sdr_source_t {
+	rtlsdr_dev_t *dev;	//  device, or
+	FILE *fid;		//  recorded samples
+	uint32_t samp_rate;
+	timetag_t *tt;
+	volatile sig_atomic_t stop;	//  set by sdr_source_cancel
+};
+
+sdr_source_t *
+sdr_source_device (char *device, uint32_t samp_rate, uint32_t frequency,
+		int gain, int ppm_error)
+{
+	rtlsdr_dev_t *dev;
+	int index = verbose_device_search(device ? device : "0");
+
+	if (index < 0)
+		return NULL;
+
+	if (rtlsdr_open(&dev, (uint32_t) index) < 0) {
+		fprintf(stderr, "Failed to open rtlsdr device #%d.\n", index);
+		return NULL;
+	}
+
+	verbose_set_sample_rate(dev, samp_rate);
+	verbose_set_frequency(dev, frequency);
+
+	if (gain == 0) {
+		verbose_auto_gain(dev);
+	} else {
+		gain = nearest_gain(dev, gain);
+		verbose_gain_set(dev, gain);
+	}
+
+	verbose_ppm_set(dev, ppm_error);
+
+	sdr_source_t *self = (sdr_source_t *) malloc (sizeof (sdr_source_t));
+	assert(self);
+
+	self->dev = dev;
+	self->fid = NULL;
+	self->samp_rate = samp_rate;
+	self->tt = timetag_create(samp_rate, 1);
+	self->stop = 0;
+
+	return self;
+}
+
+sdr_source_t *
+sdr_source_file (FILE *fid, uint32_t samp_rate)
+{
+	assert(fid);
+
+	sdr_source_t *self = (sdr_source_t *) malloc (sizeof (sdr_source_t));
+	assert(self);
+
+	self->dev = NULL;
+	self->fid = fid;
+	self->samp_rate = samp_rate;
+	self->tt = timetag_create(samp_rate, 0);
+	self->stop = 0;
+
+	return self;
+}
+
+uint32_t
+sdr_source_rate (sdr_source_t *self)
+{
+	assert(self);
+	return self->samp_rate;
+}
+
+timetag_t *
+sdr_source_timetag (sdr_source_t *self)
+{
+	assert(self);
+	return self->tt;
+}
+
+void
+sdr_source_start (sdr_source_t *self)
+{
+	assert(self);
+	if (self->dev)
+		verbose_reset_buffer(self->dev);
+}
+
+int
+sdr_source_read (sdr_source_t *self, uint8_t *buf, unsigned int n,
+		blockmeta_t *meta)
+{
+	int n_read;
+
+	assert(self);
+
+	if (self->stop)
+		return 0;
+
+	if (self->fid) {
+		//  whole samples only, a trailing odd byte is dropped
+		n_read = fread(buf, 1, 2 * n, self->fid) & ~1;
+	} else if (rtlsdr_read_sync(self->dev, buf, 2 * n, &n_read) < 0) {
+		return -1;
+	}
+
+	if (n_read > 0)
+		timetag_capture(self->tt, n_read / 2, meta);
+
+	return n_read / 2;
+}
+
+//  rtlsdr_cancel_async() only stops rtlsdr_read_async(), a sync read
+//  cannot be interrupted, so this just ends the stream
+void
+sdr_source_cancel (sdr_source_t *self)
+{
+	if (self)
+		self->stop = 1;
+}
+
+void
+sdr_source_destroy (sdr_source_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		sdr_source_t *self = *self_p;
+
+		if (self->dev)
+			rtlsdr_close(self->dev);
+		timetag_destroy(&self->tt);
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
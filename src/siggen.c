@@ -0,0 +1,224 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+#include <assert.h>
+
+#include "debug.h"
+#include "siggen.h"
+
+#define TWO_PI	6.283185307179586
+
+typedef enum {
+	SOURCE_FM_TONE,
+	SOURCE_BURST
+} source_type_t;
+
+typedef struct {
+	source_type_t type;
+	float amplitude;
+	double carrier_step;	//  carrier phase increment [rad/sample]
+	double tone_step;	//  modulating tone phase increment [rad/sample]
+	double beta;		//  modulation index, deviation / tone
+	uint64_t on;		//  burst: keyed samples per period
+	uint64_t period;	//  burst: period [samples]
+} source_t;
+
+struct _siggen_t {
+	uint32_t samp_rate;
+	uint32_t state;		//  xorshift32 state
+	uint64_t sample;	//  absolute sample index
+	float snr_db;
+	int noise;
+	unsigned int n_sources;
+	source_t sources[SIGGEN_MAX_SOURCES];
+};
+
+//  xorshift32, so output does not depend on the libc rand()
+static inline uint32_t
+s_rand (siggen_t *self)
+{
+	uint32_t x = self->state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return self->state = x;
+}
+
+//  Uniform in (0, 1]
+static inline float
+s_uniform (siggen_t *self)
+{
+	return ((s_rand(self) >> 8) + 1) * (1.0f / 16777216.0f);
+}
+
+siggen_t *
+siggen_create (uint32_t samp_rate, uint32_t seed)
+{
+	siggen_t *self = (siggen_t *) malloc (sizeof (siggen_t));
+	assert(self);
+	memset(self, 0, sizeof(siggen_t));
+
+	self->samp_rate = samp_rate;
+	self->state = seed ? seed : 0x2545f491;
+
+	return self;
+}
+
+int
+siggen_add_fm_tone (siggen_t *self, float offset, float amplitude,
+			float tone, float deviation)
+{
+	source_t *s;
+
+	assert(self);
+	if (self->n_sources == SIGGEN_MAX_SOURCES)
+		return -1;
+
+	s = &self->sources[self->n_sources++];
+	s->type = SOURCE_FM_TONE;
+	s->amplitude = amplitude;
+	s->carrier_step = TWO_PI * offset / self->samp_rate;
+	s->tone_step = TWO_PI * tone / self->samp_rate;
+	s->beta = (tone > 0.0f) ? deviation / tone : 0.0;
+
+	return 0;
+}
+
+int
+siggen_add_burst (siggen_t *self, float offset, float amplitude,
+			float on, float period)
+{
+	source_t *s;
+
+	assert(self);
+	if (self->n_sources == SIGGEN_MAX_SOURCES || period <= 0.0f)
+		return -1;
+
+	s = &self->sources[self->n_sources++];
+	s->type = SOURCE_BURST;
+	s->amplitude = amplitude;
+	s->carrier_step = TWO_PI * offset / self->samp_rate;
+	s->on = (uint64_t)(on * self->samp_rate);
+	s->period = (uint64_t)(period * self->samp_rate);
+	if (s->period == 0)
+		s->period = 1;
+
+	return 0;
+}
+
+void
+siggen_set_snr (siggen_t *self, float snr_db)
+{
+	assert(self);
+	self->snr_db = snr_db;
+	self->noise = 1;
+}
+
+void
+siggen_generate (siggen_t *self, complex float *x, unsigned int n)
+{
+	unsigned int i, k;
+	float power = 0.0f;
+	float sigma = 0.0f;
+
+	assert(self);
+	memset(x, 0, n * sizeof(complex float));
+
+	for (k = 0; k < self->n_sources; k++) {
+		source_t *s = &self->sources[k];
+
+		power += s->amplitude * s->amplitude;
+		for (i = 0; i < n; i++) {
+			//  phases from the absolute sample index, so there is no
+			//  accumulated drift however long the run is
+			double t = (double)(self->sample + i);
+			double phi = fmod(s->carrier_step * t, TWO_PI);
+
+			if (s->type == SOURCE_FM_TONE) {
+				phi += s->beta * sin(fmod(s->tone_step * t, TWO_PI));
+			} else if ((self->sample + i) % s->period >= s->on) {
+				continue;
+			}
+			x[i] += s->amplitude * (float)cos(phi) +
+				_Complex_I * s->amplitude * (float)sin(phi);
+		}
+	}
+
+	if (self->noise && power > 0.0f)
+		sigma = sqrtf(power * powf(10.0f, -self->snr_db / 10.0f) / 2.0f);
+
+	if (sigma > 0.0f) {
+		//  Box-Muller, one complex sample per pair of uniforms
+		for (i = 0; i < n; i++) {
+			float r = sigma * sqrtf(-2.0f * logf(s_uniform(self)));
+			float a = (float)TWO_PI * s_uniform(self);
+			x[i] += r * cosf(a) + _Complex_I * r * sinf(a);
+		}
+	}
+
+	self->sample += n;
+}
+
+static inline uint8_t
+s_quantize (float f, unsigned int *clipped)
+{
+	float u = f * 128.0f + 127.4f;
+
+	if (u < 0.0f) {
+		(*clipped)++;
+		return 0;
+	}
+	if (u > 255.0f) {
+		(*clipped)++;
+		return 255;
+	}
+	return (uint8_t) lrintf(u);
+}
+
+unsigned int
+siggen_to_cu8 (const complex float *x, uint8_t *y, unsigned int n)
+{
+	unsigned int i;
+	unsigned int clipped = 0;
+
+	for (i = 0; i < n; i++) {
+		y[2*i]     = s_quantize(crealf(x[i]), &clipped);
+		y[2*i + 1] = s_quantize(cimagf(x[i]), &clipped);
+	}
+
+	return clipped;
+}
+
+void
+siggen_destroy (siggen_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		siggen_t *self = *self_p;
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
@@ -0,0 +1,243 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fftw3.h>
+
+#include "debug.h"
+#include "spectrum.h"
+
+//  Frames are collected and transformed in batches of about this many
+//  samples, one FFTW call per batch
+#define BATCH_SAMPLES	16384
+
+//  FFTW_MEASURE once a wisdom cache is in use
+static unsigned int s_plan_flags = FFTW_ESTIMATE;
+
+struct _spectrum_t {
+	unsigned int nfft;
+	unsigned int batch;	//  frames per FFTW call
+	unsigned int pos;	//  samples in current frame
+	unsigned int filled;	//  complete frames waiting in the batch
+	unsigned int frames;	//  frames transformed since last read
+	float *win;		//  Hann window
+	float norm;		//  1 / (sum of window)^2
+	complex float *in;	//  FFTW buffers, batch frames each
+	complex float *out;
+	fftwf_plan plan;	//  whole batch
+	fftwf_plan plan1;	//  single frame, for partial batches
+	double *acc;		//  summed power per bin
+};
+
+spectrum_t *
+spectrum_create (unsigned int nfft)
+{
+	unsigned int i;
+	double sum = 0.0;
+
+	assert(nfft > 1);
+
+	spectrum_t *self = (spectrum_t *) malloc (sizeof (spectrum_t));
+	assert(self);
+
+	self->nfft = nfft;
+	self->batch = (nfft < BATCH_SAMPLES) ? BATCH_SAMPLES / nfft : 1;
+	self->pos = 0;
+	self->filled = 0;
+	self->frames = 0;
+	self->win = malloc(nfft * sizeof(float));
+	self->acc = calloc(nfft, sizeof(double));
+	self->in = fftwf_malloc(nfft * self->batch * sizeof(complex float));
+	self->out = fftwf_malloc(nfft * self->batch * sizeof(complex float));
+	assert(self->win && self->acc && self->in && self->out);
+
+	for (i = 0; i < nfft; i++) {
+		self->win[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / nfft);
+		sum += self->win[i];
+	}
+	self->norm = (float)(1.0 / (sum * sum));
+
+	self->plan = fftwf_plan_many_dft(1, (int *) &self->nfft, self->batch,
+			(fftwf_complex *) self->in, NULL, 1, nfft,
+			(fftwf_complex *) self->out, NULL, 1, nfft,
+			FFTW_FORWARD, s_plan_flags);
+	assert(self->plan);
+
+	//  frames past the first keep its SIMD alignment unless nfft is odd
+	//  or small, FFTW needs to know for execute_dft at those offsets
+	self->plan1 = NULL;
+	if (self->batch > 1) {
+		unsigned int flags = s_plan_flags;
+		if (fftwf_alignment_of((float *) (self->in + nfft)) !=
+				fftwf_alignment_of((float *) self->in) ||
+		    fftwf_alignment_of((float *) (self->out + nfft)) !=
+				fftwf_alignment_of((float *) self->out))
+			flags |= FFTW_UNALIGNED;
+		self->plan1 = fftwf_plan_dft_1d(nfft,
+				(fftwf_complex *) self->in, (fftwf_complex *) self->out,
+				FFTW_FORWARD, flags);
+		assert(self->plan1);
+	}
+
+	return self;
+}
+
+//  Transform the first n frames of the batch and add their power
+static void
+s_flush (spectrum_t *self, unsigned int n)
+{
+	const float *o = (const float *) self->out;
+	unsigned int f, i;
+
+	if (n == self->batch)
+		fftwf_execute(self->plan);
+	else
+		for (f = 0; f < n; f++)
+			fftwf_execute_dft(self->plan1,
+					(fftwf_complex *) (self->in + f * self->nfft),
+					(fftwf_complex *) (self->out + f * self->nfft));
+
+	for (f = 0; f < n; f++) {
+		for (i = 0; i < self->nfft; i++)
+			self->acc[i] += o[2*i] * o[2*i] + o[2*i+1] * o[2*i+1];
+		o += 2 * self->nfft;
+	}
+	self->frames += n;
+	self->filled = 0;
+}
+
+void
+spectrum_write (spectrum_t *self, const complex float *x, unsigned int n)
+{
+	unsigned int i;
+
+	assert(self);
+
+	while (n > 0) {
+		complex float *in = self->in + self->filled * self->nfft;
+		unsigned int len = self->nfft - self->pos;
+		if (len > n)
+			len = n;
+
+		for (i = 0; i < len; i++)
+			in[self->pos + i] = x[i] * self->win[self->pos + i];
+		self->pos += len;
+		x += len;
+		n -= len;
+
+		if (self->pos == self->nfft) {
+			self->pos = 0;
+			if (++self->filled == self->batch)
+				s_flush(self, self->batch);
+		}
+	}
+}
+
+unsigned int
+spectrum_frames (spectrum_t *self)
+{
+	assert(self);
+	return self->frames + self->filled;
+}
+
+unsigned int
+spectrum_read (spectrum_t *self, float *psd)
+{
+	unsigned int i, frames;
+	unsigned int half = self->nfft / 2;
+
+	assert(self);
+
+	//  frames of a partial batch are transformed one by one
+	if (self->filled > 0)
+		s_flush(self, self->filled);
+
+	frames = self->frames;
+	if (frames == 0)
+		return 0;
+
+	for (i = 0; i < self->nfft; i++) {
+		float p = (float)(self->acc[i] / frames) * self->norm;
+		psd[(i + half) % self->nfft] = 10.0f * log10f(p + 1e-20f);
+		self->acc[i] = 0.0;
+	}
+	self->frames = 0;
+
+	return frames;
+}
+
+int
+spectrum_wisdom_load (const char *filename)
+{
+	if (!fftwf_import_wisdom_from_filename(filename))
+		return -1;
+	s_plan_flags = FFTW_MEASURE;
+	return 0;
+}
+
+void
+spectrum_wisdom_measure (void)
+{
+	s_plan_flags = FFTW_MEASURE;
+}
+
+int
+spectrum_wisdom_save (const char *filename)
+{
+	char tmp[512];
+
+	//  write aside and rename, so a concurrent load never sees a
+	//  partial file and a failed write keeps the old one
+	if ((size_t) snprintf(tmp, sizeof(tmp), "%s.tmp.%ld",
+			filename, (long) getpid()) >= sizeof(tmp))
+		return -1;
+
+	if (!fftwf_export_wisdom_to_filename(tmp) || rename(tmp, filename) != 0) {
+		remove(tmp);
+		return -1;
+	}
+
+	return 0;
+}
+
+void
+spectrum_destroy (spectrum_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		spectrum_t *self = *self_p;
+
+		fftwf_destroy_plan(self->plan);
+		if (self->plan1)
+			fftwf_destroy_plan(self->plan1);
+		fftwf_free(self->in);
+		fftwf_free(self->out);
+		free (self->win);
+		free (self->acc);
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
@@ -0,0 +1,130 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <assert.h>
+#include <sys/stat.h>
+
+#include "debug.h"
+#include "startup.h"
+
+struct _startup_t {
+	struct timespec t0;
+	struct timespec last;
+	unsigned int n;
+	const char *phase[STARTUP_MAX_PHASES];
+	double ms[STARTUP_MAX_PHASES];
+};
+
+static double
+s_ms (const struct timespec *a, const struct timespec *b)
+{
+	return (b->tv_sec - a->tv_sec) * 1e3 + (b->tv_nsec - a->tv_nsec) * 1e-6;
+}
+
+startup_t *
+startup_create (void)
+{
+	startup_t *self = (startup_t *) malloc (sizeof (startup_t));
+	assert(self);
+
+	clock_gettime(CLOCK_MONOTONIC, &self->t0);
+	self->last = self->t0;
+	self->n = 0;
+
+	return self;
+}
+
+void
+startup_mark (startup_t *self, const char *phase)
+{
+	struct timespec now;
+
+	assert(self);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (self->n < STARTUP_MAX_PHASES) {
+		self->phase[self->n] = phase;
+		self->ms[self->n] = s_ms(&self->last, &now);
+		self->n++;
+	}
+	self->last = now;
+}
+
+void
+startup_report (startup_t *self, FILE *fid)
+{
+	unsigned int i;
+
+	assert(self);
+	fprintf(fid, "startup         :   %10.3f [ms] (", s_ms(&self->t0, &self->last));
+	for (i = 0; i < self->n; i++)
+		fprintf(fid, "%s%s %.3f", i ? ", " : "", self->phase[i], self->ms[i]);
+	fprintf(fid, ")\n");
+}
+
+static int
+s_mkdir (const char *path)
+{
+	return (mkdir(path, 0755) == 0 || errno == EEXIST) ? 0 : -1;
+}
+
+int
+startup_cache_file (const char *dir, const char *name, char *path, size_t size)
+{
+	char base[512];
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+
+	if (dir) {
+		snprintf(base, sizeof(base), "%s", dir);
+	} else if (xdg && *xdg) {
+		snprintf(base, sizeof(base), "%s/sdr_rec", xdg);
+	} else if (home && *home) {
+		snprintf(base, sizeof(base), "%s/.cache", home);
+		if (s_mkdir(base) != 0)
+			return -1;
+		snprintf(base, sizeof(base), "%s/.cache/sdr_rec", home);
+	} else {
+		return -1;
+	}
+
+	if (s_mkdir(base) != 0)
+		return -1;
+	if ((size_t) snprintf(path, size, "%s/%s", base, name) >= size)
+		return -1;
+
+	return 0;
+}
+
+void
+startup_destroy (startup_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		startup_t *self = *self_p;
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
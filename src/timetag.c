@@ -0,0 +1,223 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+#include "debug.h"
+#include "timetag.h"
+
+#define LATE_HISTORY		8	//  blocks a delay must persist to count as a gap,
+					//  see timetag.h when changing it
+#define BASELINE_FOLLOW		0.01	//  rate the baseline follows clock drift
+#define GAP_MIN			0.01	//  smallest detectable gap [s]
+
+struct _timetag_t {
+	double samp_rate;
+	int live;
+
+	uint64_t seq;
+	uint64_t sample;	//  captured samples, including lost ones
+	uint64_t lost;
+	int started;
+
+	double mono0;		//  CLOCK_MONOTONIC of sample 0 [s]
+	int64_t utc_offset;	//  UTC - CLOCK_MONOTONIC [ns]
+	double baseline;	//  usual arrival lateness [s]
+	double late[LATE_HISTORY];
+	unsigned int late_pos;
+	unsigned int late_len;
+};
+
+static int64_t
+s_now_ns (clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+timetag_t *
+timetag_create (uint32_t samp_rate, int live)
+{
+	timetag_t *self = (timetag_t *) malloc (sizeof (timetag_t));
+	assert(self);
+	memset(self, 0, sizeof(timetag_t));
+
+	self->samp_rate = samp_rate;
+	self->live = live;
+
+	return self;
+}
+
+void
+timetag_capture (timetag_t *self, unsigned int n, blockmeta_t *meta)
+{
+	int64_t now_ns = s_now_ns(CLOCK_MONOTONIC);
+	double now = now_ns * 1e-9;
+	uint64_t gap = 0;
+	unsigned int i;
+
+	assert(self);
+
+	if (!self->started) {
+		//  block's last sample arrived now
+		self->mono0 = now - n / self->samp_rate;
+		self->utc_offset = s_now_ns(CLOCK_REALTIME) - now_ns;
+		self->started = 1;
+	} else if (self->live) {
+		//  lateness of this block's last sample against the sample
+		//  clock; USB bursts and scheduling make it jitter upwards,
+		//  dropped transfers shift it up for good
+		double late = now - (self->mono0 + (self->sample + n) / self->samp_rate);
+		double low;
+
+		self->late[self->late_pos] = late;
+		self->late_pos = (self->late_pos + 1) % LATE_HISTORY;
+		if (self->late_len < LATE_HISTORY)
+			self->late_len++;
+
+		if (self->late_len == 1)
+			self->baseline = late;
+
+		low = late;
+		for (i = 0; i < self->late_len; i++)
+			if (self->late[i] < low)
+				low = self->late[i];
+
+		//  a gap worth at least a few blocks that persisted over the
+		//  whole history, i.e. it was not just a late read
+		double threshold = fmax(4.0 * n / self->samp_rate, GAP_MIN);
+		if (self->late_len == LATE_HISTORY && low - self->baseline > threshold) {
+			gap = (uint64_t) llround((low - self->baseline) * self->samp_rate);
+			for (i = 0; i < self->late_len; i++)
+				self->late[i] -= gap / self->samp_rate;
+		} else if (low < self->baseline) {
+			self->baseline = low;
+		} else {
+			self->baseline += BASELINE_FOLLOW * (low - self->baseline);
+		}
+	}
+
+	self->sample += gap;
+	self->lost += gap;
+
+	double t = self->mono0 + self->baseline + self->sample / self->samp_rate;
+	meta->seq = self->seq++;
+	meta->sample = self->sample;
+	meta->mono_ns = (uint64_t) llround(t * 1e9);
+	meta->utc_ns = meta->mono_ns + self->utc_offset;
+	meta->gap = gap;
+	meta->n = n;
+	meta->rate = self->samp_rate;
+
+	self->sample += n;
+}
+
+void
+timetag_map_init (timetag_map_t *map, double in_rate, double rate,
+		float delay)
+{
+	assert(map);
+	assert(in_rate > 0.0 && rate > 0.0);
+
+	memset(map, 0, sizeof(timetag_map_t));
+	map->rate = rate;
+	map->delay = delay * in_rate / rate;
+}
+
+void
+timetag_output (timetag_map_t *map, const blockmeta_t *in, unsigned int n,
+		blockmeta_t *out)
+{
+	double ratio, pos, dt;
+
+	assert(map);
+	assert(map->rate > 0.0);
+
+	ratio = map->rate / in->rate;
+
+	//  gaps are reported with the block that follows them
+	map->skew += in->gap;
+	map->gap += in->gap;
+
+	//  input sample position of the first output sample
+	pos = map->sample / ratio + map->skew - map->delay;
+	dt = (pos - (double) in->sample) / in->rate;
+
+	out->seq = in->seq;
+	out->sample = map->sample;
+	out->mono_ns = in->mono_ns + llround(dt * 1e9);
+	out->utc_ns = in->utc_ns + llround(dt * 1e9);
+	out->gap = (uint64_t) llround(map->gap * ratio);
+	out->n = n;
+	out->rate = map->rate;
+
+	map->gap = 0;
+	map->sample += n;
+}
+
+uint64_t
+timetag_lost (timetag_t *self)
+{
+	assert(self);
+	return self->lost;
+}
+
+void
+blockmeta_print (const blockmeta_t *meta, FILE *fid)
+{
+	fprintf(fid, "%llu %llu %u %.3f %llu %llu %llu\n",
+		(unsigned long long) meta->seq,
+		(unsigned long long) meta->sample,
+		meta->n, meta->rate,
+		(unsigned long long) meta->mono_ns,
+		(unsigned long long) meta->utc_ns,
+		(unsigned long long) meta->gap);
+}
+
+void
+timetag_format_utc (uint64_t utc_ns, char *buf, size_t size)
+{
+	char tmp[32];
+	time_t sec = utc_ns / 1000000000ULL;
+	struct tm tm;
+
+	gmtime_r(&sec, &tm);
+	strftime(tmp, sizeof(tmp), "%Y-%m-%dT%H:%M:%S", &tm);
+	snprintf(buf, size, "%s.%06uZ", tmp,
+		 (unsigned int)((utc_ns % 1000000000ULL) / 1000));
+}
+
+void
+timetag_destroy (timetag_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		timetag_t *self = *self_p;
+
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
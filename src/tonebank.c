@@ -0,0 +1,169 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <complex.h>
+#include <math.h>
+#include <assert.h>
+
+#include "debug.h"
+#include "tonebank.h"
+
+typedef struct {
+	float coeff;		//  2 cos(w)
+	float complex rot;	//  exp(-jw)
+	float complex s1;	//  Goertzel state
+	float complex s2;
+	double acc;		//  summed frame power
+} tone_t;
+
+struct _tonebank_t {
+	unsigned int n;
+	tone_t *tones;
+	unsigned int window;
+	unsigned int pos;	//  samples into current frame
+	unsigned int frames;	//  frames in acc
+	float *win;		//  Hann window
+	float norm;		//  1 / (sum of window)^2
+	float complex *scratch;	//  windowed samples, shared by all tones
+};
+
+tonebank_t *
+tonebank_create (const float *offsets, unsigned int n,
+		uint32_t samp_rate, unsigned int window)
+{
+	unsigned int i;
+	double sum = 0.0;
+
+	assert(window > 1);
+
+	tonebank_t *self = (tonebank_t *) malloc (sizeof (tonebank_t));
+	assert(self);
+
+	self->n = n;
+	self->window = window;
+	self->pos = 0;
+	self->frames = 0;
+
+	self->tones = calloc(n, sizeof(tone_t));
+	self->win = malloc(window * sizeof(float));
+	self->scratch = malloc(window * sizeof(complex float));
+	assert(self->tones && self->win && self->scratch);
+
+	for (i = 0; i < n; i++) {
+		double w = 2.0 * M_PI * offsets[i] / samp_rate;
+
+		self->tones[i].coeff = (float)(2.0 * cos(w));
+		self->tones[i].rot = (float)cos(w) - _Complex_I * (float)sin(w);
+	}
+
+	for (i = 0; i < window; i++) {
+		self->win[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (window - 1));
+		sum += self->win[i];
+	}
+	self->norm = (float)(1.0 / (sum * sum));
+
+	return self;
+}
+
+void
+tonebank_execute (tonebank_t *self, const complex float *x, unsigned int n)
+{
+	unsigned int i, k;
+
+	assert(self);
+
+	while (n > 0) {
+		unsigned int len = self->window - self->pos;
+		if (len > n)
+			len = n;
+
+		//  window once, then run every tone over the same buffer
+		for (i = 0; i < len; i++)
+			self->scratch[i] = x[i] * self->win[self->pos + i];
+
+		for (k = 0; k < self->n; k++) {
+			tone_t *t = &self->tones[k];
+			const float c = t->coeff;
+			float complex s1 = t->s1, s2 = t->s2;
+
+			for (i = 0; i < len; i++) {
+				float complex s0 = self->scratch[i] + c * s1 - s2;
+				s2 = s1;
+				s1 = s0;
+			}
+			t->s1 = s1;
+			t->s2 = s2;
+		}
+
+		self->pos += len;
+		x += len;
+		n -= len;
+
+		if (self->pos == self->window) {
+			for (k = 0; k < self->n; k++) {
+				tone_t *t = &self->tones[k];
+				float complex y = t->s1 - t->rot * t->s2;
+
+				t->acc += (crealf(y) * crealf(y) + cimagf(y) * cimagf(y)) * self->norm;
+				t->s1 = 0.0f;
+				t->s2 = 0.0f;
+			}
+			self->frames++;
+			self->pos = 0;
+		}
+	}
+}
+
+unsigned int
+tonebank_read (tonebank_t *self, float *power)
+{
+	unsigned int k, frames;
+
+	assert(self);
+	frames = self->frames;
+	if (frames == 0)
+		return 0;
+
+	for (k = 0; k < self->n; k++) {
+		power[k] = 10.0f * log10f((float)(self->tones[k].acc / frames) + 1e-20f);
+		self->tones[k].acc = 0.0;
+	}
+	self->frames = 0;
+
+	return frames;
+}
+
+void
+tonebank_destroy (tonebank_t **self_p)
+{
+	assert (self_p);
+	if (*self_p) {
+		tonebank_t *self = *self_p;
+
+		free (self->tones);
+		free (self->win);
+		free (self->scratch);
+		//  Free object itself
+		free (self);
+		*self_p = NULL;
+	}
+}
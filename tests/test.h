@@ -0,0 +1,92 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Helpers shared by the test drivers: each driver runs its checks,
+//  reports every failure on stderr and exits non-zero if any failed.
+
+#ifndef __TEST_H_INCLUDED__
+#define __TEST_H_INCLUDED__
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+static int test_failures = 0;
+
+//  Count and report a failed expectation, then carry on
+#define CHECK(cond, ...) do {                                           \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);        \
+            fprintf(stderr, __VA_ARGS__);                               \
+            fprintf(stderr, "\n");                                      \
+            test_failures++;                                            \
+        }                                                               \
+    } while (0)
+
+static inline double test_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//  Least squares fit of a sine at f [Hz] to y: amplitude, and power of
+//  the fit over power of the residual [dB]
+static inline void test_tone_fit(const float *y, unsigned int n, double f, double rate,
+                                 double *amp, double *snr_db)
+{
+    double cc = 0, ss = 0, cs = 0, yc = 0, ys = 0, yy = 0, a, b, det, sig;
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        double c = cos(2 * M_PI * f * i / rate), s = sin(2 * M_PI * f * i / rate);
+        cc += c * c;
+        ss += s * s;
+        cs += c * s;
+        yc += y[i] * c;
+        ys += y[i] * s;
+        yy += (double)y[i] * y[i];
+    }
+    det = cc * ss - cs * cs;
+    a = (yc * ss - ys * cs) / det;
+    b = (ys * cc - yc * cs) / det;
+    sig = a * yc + b * ys;
+
+    *amp = sqrt(a * a + b * b);
+    *snr_db = 10.0 * log10(sig / (yy - sig + 1e-30));
+}
+
+//  Frequency [Hz] from the positive-going zero crossings of y
+static inline double test_crossing_freq(const float *y, unsigned int n, double rate)
+{
+    unsigned int i, first = 0, last = 0, count = 0;
+
+    for (i = 1; i < n; i++) {
+        if (y[i-1] < 0.0f && y[i] >= 0.0f) {
+            if (count == 0)
+                first = i;
+            last = i;
+            count++;
+        }
+    }
+
+    return (count > 1) ? (count - 1) * rate / (last - first) : 0.0;
+}
+
+#endif /* __TEST_H_INCLUDED__ */
@@ -0,0 +1,167 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Both receiver chains on generated 8-bit I/Q, no hardware:
+//  rtl_demod   siggen -> normalizer -> sdr_channel -> demod
+//  rtl_asgram  siggen -> normalizer -> spectrum
+//  Usage: test_chain [throughput floor, x real time at 2.048 MHz]
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define RATE        2048000
+#define BLOCK       16384
+#define BANDWIDTH   24000.0f
+#define NFFT        256
+#define BIN         40                              //  tone offset in bins
+#define OFFSET      ((float)BIN * RATE / NFFT)      //  320 kHz
+
+//  Two seconds of generated signal as the dongle would deliver it
+static uint8_t *make_cu8(unsigned int n, float offset, float tone,
+                         float deviation, float snr)
+{
+    complex float *x = malloc(n * sizeof(complex float));
+    uint8_t *raw = malloc(2 * n);
+    assert(x && raw);
+
+    siggen_t *gen = siggen_create(RATE, 1);
+    siggen_add_fm_tone(gen, offset, 0.5f, tone, deviation);
+    siggen_set_snr(gen, snr);
+    siggen_generate(gen, x, n);
+    siggen_to_cu8(x, raw, n);
+    siggen_destroy(&gen);
+    free(x);
+
+    return raw;
+}
+
+//  NBFM tone: right frequency, full deviation, clean
+static void test_demod_chain(double min_speed)
+{
+    unsigned int n = 2 * RATE / BLOCK * BLOCK;
+    unsigned int i, m = 0, skip;
+    double amp, snr, freq, t;
+    float rate;
+
+    uint8_t *raw = make_cu8(n, 0.0f, 1000.0f, 5000.0f, 30.0f);
+    complex float *iq = malloc(BLOCK * sizeof(complex float));
+    assert(iq);
+
+    normalizer_t *norm = normalizer_create();
+    sdr_channel_t *chan = sdr_channel_create(RATE, BANDWIDTH, BLOCK);
+    rate = sdr_channel_rate(chan);
+    complex float *y = malloc(sdr_channel_max_out(chan) * sizeof(complex float));
+    float *audio = malloc((n / BLOCK + 1) * sdr_channel_max_out(chan) * sizeof(float));
+    demod_t *dem = demod_create(DEMOD_NBFM, rate, 0.0f, sdr_channel_max_out(chan));
+    assert(y && audio);
+
+    t = test_now();
+    for (i = 0; i < n; i += BLOCK) {
+        normalizer_convert(norm, raw + 2 * i, iq, BLOCK);
+        unsigned int nw = sdr_channel_execute(chan, iq, BLOCK, NULL, y, NULL);
+        demod_execute(dem, y, nw, audio + m);
+        m += nw;
+    }
+    t = test_now() - t;
+
+    //  full deviation is +-1.0; skip the filter start-up and fit at the
+    //  measured frequency, so amplitude and SNR are checked
+    //  independently of a small rate error
+    skip = (unsigned int)(0.25f * rate);
+    freq = test_crossing_freq(audio + skip, m - skip, rate);
+    test_tone_fit(audio + skip, m - skip, freq, rate, &amp, &snr);
+    printf("demod chain     :   tone %.1f Hz, amplitude %.3f, SNR %.1f dB, %.1fx real time\n",
+           freq, amp, snr, n / t / RATE);
+
+    CHECK(fabs(freq - 1000.0) < 10.0, "tone at %.1f Hz, expected 1000 Hz", freq);
+    CHECK(fabs(amp - 1.0) < 0.1, "tone amplitude %.3f, expected 1.0", amp);
+    CHECK(snr > 20.0, "SNR %.1f dB, expected > 20 dB", snr);
+    CHECK(n / t > min_speed * RATE, "demod chain runs at %.1fx real time, floor %.0fx",
+          n / t / RATE, min_speed);
+
+    demod_destroy(&dem);
+    sdr_channel_destroy(&chan);
+    normalizer_destroy(&norm);
+    free(audio);
+    free(y);
+    free(iq);
+    free(raw);
+}
+
+//  Carrier in the right bin at the right level above the noise floor
+static void test_spectrum_chain(double min_speed)
+{
+    unsigned int n = 2 * RATE / BLOCK * BLOCK, i, peak = 0;
+    float psd[NFFT], worst = -1e30f;
+    double t;
+
+    uint8_t *raw = make_cu8(n, OFFSET, 0.0f, 0.0f, 40.0f);
+    complex float *iq = malloc(BLOCK * sizeof(complex float));
+    assert(iq);
+
+    normalizer_t *norm = normalizer_create();
+    spectrum_t *spec = spectrum_create(NFFT);
+
+    t = test_now();
+    for (i = 0; i < n; i += BLOCK) {
+        normalizer_convert(norm, raw + 2 * i, iq, BLOCK);
+        spectrum_write(spec, iq, BLOCK);
+    }
+    t = test_now() - t;
+
+    CHECK(spectrum_read(spec, psd) == n / NFFT, "spectrum averaged the wrong number of frames");
+
+    for (i = 1; i < NFFT; i++)
+        if (psd[i] > psd[peak])
+            peak = i;
+    for (i = 0; i < NFFT; i++)
+        if (abs((int)i - (int)peak) > 2 && psd[i] > worst)
+            worst = psd[i];
+
+    printf("spectrum chain  :   peak bin %u at %.2f dB, worst other bin %.1f dB, %.1fx real time\n",
+           peak, psd[peak], worst, n / t / RATE);
+
+    //  40 dB SNR over 256 bins puts the noise near -70 dB per bin
+    CHECK(peak == NFFT / 2 + BIN, "peak in bin %u, expected %u", peak, NFFT / 2 + BIN);
+    CHECK(fabs(psd[peak] + 6.02) < 0.2, "peak %.2f dB, expected -6.02 dB", psd[peak]);
+    CHECK(worst < -60.0f, "other bins up to %.1f dB, expected < -60 dB", worst);
+    CHECK(n / t > min_speed * RATE, "spectrum chain runs at %.1fx real time, floor %.0fx",
+          n / t / RATE, min_speed);
+
+    spectrum_destroy(&spec);
+    normalizer_destroy(&norm);
+    free(iq);
+    free(raw);
+}
+
+int main(int argc, char **argv)
+{
+    double min_speed = (argc > 1) ? atof(argv[1]) : 2.0;
+
+    test_demod_chain(min_speed);
+    test_spectrum_chain(min_speed);
+
+    return test_failures ? 1 : 0;
+}
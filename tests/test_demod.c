@@ -0,0 +1,169 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Demodulators on their own: AM envelope and synchronous, SSB sideband
+//  selection at channel rates up to 800 kHz, throughput of every mode.
+//  Usage: test_demod [throughput floor, x real time at 240 kHz]
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define DEMOD_RATE      240000
+#define DEMOD_BLOCK     8192
+
+static void run(demod_t *dem, const complex float *x, unsigned int n, float *y)
+{
+    unsigned int i;
+
+    for (i = 0; i < n; i += DEMOD_BLOCK)
+        demod_execute(dem, x + i, (n - i < DEMOD_BLOCK) ? n - i : DEMOD_BLOCK, y + i);
+}
+
+//  50% AM on a carrier 40 Hz off, envelope and synchronous
+static void test_am(void)
+{
+    unsigned int n = DEMOD_RATE, i;
+    int track;
+    double amp, snr;
+
+    complex float *x = malloc(n * sizeof(complex float));
+    float *y = malloc(n * sizeof(float));
+    assert(x && y);
+
+    for (i = 0; i < n; i++)
+        x[i] = 0.3f * (1.0f + 0.5f * cosf(2.0f * (float)M_PI * 700.0f * i / DEMOD_RATE)) *
+               cexpf(_Complex_I * (float)fmod(2.0 * M_PI * 40.0 * i / DEMOD_RATE + 1.0, 2.0 * M_PI));
+
+    for (track = 0; track < 2; track++) {
+        demod_t *dem = demod_create(DEMOD_AM, DEMOD_RATE, 0.0f, DEMOD_BLOCK);
+        demod_set_carrier_tracking(dem, track);
+        run(dem, x, n, y);
+        test_tone_fit(y + n / 2, n / 2, 700.0, DEMOD_RATE, &amp, &snr);
+        printf("am%s        :   amplitude %.3f, SNR %.1f dB\n", track ? " sync" : "     ", amp, snr);
+        CHECK(fabs(amp - 0.5) < 0.05, "am (track %d) amplitude %.3f, expected 0.5", track, amp);
+        CHECK(snr > 30.0, "am (track %d) SNR %.1f dB, expected > 30 dB", track, snr);
+        demod_destroy(&dem);
+    }
+
+    free(y);
+    free(x);
+}
+
+//  Tone 1400 Hz above the carrier: passed by USB, rejected by LSB, also
+//  at rates far above the SSB bandwidth
+static void test_ssb(void)
+{
+    static const uint32_t rates[] = { 12000, 240000, 800000 };
+    unsigned int r, i;
+    double amp, snr, rej;
+
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        unsigned int n = rates[r];
+        complex float *x = malloc(n * sizeof(complex float));
+        float *y = malloc(n * sizeof(float));
+        assert(x && y);
+
+        for (i = 0; i < n; i++)
+            x[i] = 0.5f * cexpf(_Complex_I * (float)fmod(2.0 * M_PI * 1400.0 * i / rates[r], 2.0 * M_PI));
+
+        demod_t *usb = demod_create(DEMOD_USB, rates[r], 0.0f, DEMOD_BLOCK);
+        run(usb, x, n, y);
+        test_tone_fit(y + n / 2, n / 2, 1400.0, rates[r], &amp, &snr);
+        demod_destroy(&usb);
+
+        demod_t *lsb = demod_create(DEMOD_LSB, rates[r], 0.0f, DEMOD_BLOCK);
+        run(lsb, x, n, y);
+        for (i = n / 2, rej = 0.0; i < n; i++)
+            rej += (double)y[i] * y[i];
+        rej = 10.0 * log10(rej / (n / 2) / (amp * amp / 2) + 1e-30);
+        demod_destroy(&lsb);
+
+        printf("ssb %6u Hz   :   amplitude %.3f, SNR %.1f dB, opposite sideband %.1f dB\n",
+               rates[r], amp, snr, rej);
+        CHECK(fabs(amp - 0.5) < 0.03, "usb at %u Hz amplitude %.3f, expected 0.5", rates[r], amp);
+        CHECK(snr > 30.0, "usb at %u Hz SNR %.1f dB, expected > 30 dB", rates[r], snr);
+        CHECK(rej < -40.0, "lsb at %u Hz passes the upper sideband at %.1f dB", rates[r], rej);
+
+        free(y);
+        free(x);
+    }
+}
+
+//  Every mode well above real time at a typical channel rate
+static void test_throughput(double min_speed)
+{
+    static const struct { demod_mode_t mode; int track; const char *name; } modes[] = {
+        { DEMOD_NBFM, 0, "nbfm" },
+        { DEMOD_WBFM, 0, "wbfm" },
+        { DEMOD_AM,   0, "am" },
+        { DEMOD_AM,   1, "am (sync)" },
+        { DEMOD_USB,  0, "usb" },
+        { DEMOD_LSB,  0, "lsb" },
+    };
+    unsigned int n = 5 * DEMOD_RATE / DEMOD_BLOCK * DEMOD_BLOCK;
+    unsigned int i, j;
+    double t;
+
+    complex float *x = malloc(n * sizeof(complex float));
+    float *y = malloc(DEMOD_BLOCK * sizeof(float));
+    assert(x && y);
+
+    siggen_t *gen = siggen_create(DEMOD_RATE, 1);
+    siggen_add_fm_tone(gen, 0.0f, 0.5f, 1000.0f, 5000.0f);
+    siggen_set_snr(gen, 30.0f);
+    siggen_generate(gen, x, n);
+    siggen_destroy(&gen);
+
+    for (j = 0; j < sizeof(modes) / sizeof(modes[0]); j++) {
+        demod_t *dem = demod_create(modes[j].mode, DEMOD_RATE, 0.0f, DEMOD_BLOCK);
+        demod_set_carrier_tracking(dem, modes[j].track);
+
+        t = test_now();
+        for (i = 0; i < n; i += DEMOD_BLOCK)
+            demod_execute(dem, x + i, DEMOD_BLOCK, y);
+        t = test_now() - t;
+
+        printf("%-16s:   %.1f Msps (%.0fx real time)\n", modes[j].name,
+               n / t * 1e-6, n / t / DEMOD_RATE);
+        CHECK(n / t > min_speed * DEMOD_RATE, "%s runs at %.1fx real time, floor %.0fx",
+              modes[j].name, n / t / DEMOD_RATE, min_speed);
+
+        demod_destroy(&dem);
+    }
+
+    free(y);
+    free(x);
+}
+
+int main(int argc, char **argv)
+{
+    double min_speed = (argc > 1) ? atof(argv[1]) : 20.0;
+
+    test_am();
+    test_ssb();
+    test_throughput(min_speed);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  I/Q archive: lossless round trip with capture tags, index and seek,
+//  lossy shift error bound, capture gaps
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define ARCHIVE "test_iqarc.iqa"
+#define RATE    2048000
+#define FREQ    100000000ULL
+#define BLOCK   16384
+#define CHUNKS  3
+
+//  Noisy band with a few carriers, as an 8-bit capture would see it
+static uint8_t *make_iq(unsigned int n)
+{
+    complex float *x = malloc(n * sizeof(complex float));
+    uint8_t *raw = malloc(2 * n);
+    assert(x && raw);
+
+    siggen_t *gen = siggen_create(RATE, 1);
+    siggen_add_fm_tone(gen, 320000.0f, 0.3f, 1000.0f, 5000.0f);
+    siggen_add_fm_tone(gen, -500000.0f, 0.1f, 0.0f, 0.0f);
+    siggen_set_snr(gen, 20.0f);
+    siggen_generate(gen, x, n);
+    siggen_to_cu8(x, raw, n);
+    siggen_destroy(&gen);
+    free(x);
+
+    return raw;
+}
+
+static void test_lossless(void)
+{
+    unsigned int n = CHUNKS * IQARC_CHUNK_SAMPLES, nblocks = n / BLOCK, i;
+    uint64_t samples, bytes, dropped;
+    const iqarc_index_t *index;
+    iqarc_index_t chunk;
+    uint8_t *raw = make_iq(n);
+    uint8_t *y = malloc(2 * IQARC_CHUNK_SAMPLES);
+    blockmeta_t *meta = malloc(nblocks * sizeof(blockmeta_t));
+    assert(y && meta);
+
+    unlink(ARCHIVE);
+    timetag_t *tt = timetag_create(RATE, 0);
+    iqarc_writer_t *w = iqarc_writer_create(ARCHIVE, RATE, FREQ, 0);
+    CHECK(w != NULL, "cannot create '%s'", ARCHIVE);
+    if (w == NULL)
+        return;
+    iqarc_writer_set_blocking(w, 1);
+
+    for (i = 0; i < nblocks; i++) {
+        timetag_capture(tt, BLOCK, &meta[i]);
+        iqarc_writer_write(w, raw + 2 * i * BLOCK, BLOCK, &meta[i]);
+    }
+    CHECK(iqarc_writer_close(w) == 0, "close failed");
+    iqarc_writer_stats(w, &samples, &bytes, &dropped);
+    iqarc_writer_destroy(&w);
+    timetag_destroy(&tt);
+
+    printf("lossless        :   %llu samples, %llu bytes (%.2f bits/sample), %llu dropped\n",
+           (unsigned long long) samples, (unsigned long long) bytes,
+           8.0 * bytes / samples, (unsigned long long) dropped);
+    CHECK(samples == n && dropped == 0, "%llu samples, %llu dropped",
+          (unsigned long long) samples, (unsigned long long) dropped);
+    CHECK(bytes < 2ULL * n, "archive is %llu bytes, no smaller than the input", (unsigned long long) bytes);
+
+    iqarc_reader_t *r = iqarc_reader_open(ARCHIVE);
+    CHECK(r != NULL, "cannot open '%s'", ARCHIVE);
+    if (r == NULL)
+        return;
+
+    const iqarc_info_t *info = iqarc_reader_info(r);
+    CHECK(info->samp_rate == RATE && info->frequency == FREQ &&
+          info->chunk_samples == IQARC_CHUNK_SAMPLES && info->shift == 0,
+          "header reads %u Hz, %llu Hz, %u samples per chunk, shift %u", info->samp_rate,
+          (unsigned long long) info->frequency, info->chunk_samples, info->shift);
+
+    CHECK(iqarc_reader_index(r, &index) == CHUNKS, "index has %u entries, expected %u",
+          iqarc_reader_index(r, &index), CHUNKS);
+
+    //  chunks start on block boundaries, so they carry the block tags
+    for (i = 0; i < CHUNKS; i++) {
+        unsigned int b = i * IQARC_CHUNK_SAMPLES / BLOCK;
+        int m = iqarc_reader_read(r, y, &chunk);
+
+        CHECK(m == IQARC_CHUNK_SAMPLES, "chunk %u has %d samples", i, m);
+        CHECK(chunk.sample_offset == meta[b].sample, "chunk %u starts at sample %llu, expected %llu",
+              i, (unsigned long long) chunk.sample_offset, (unsigned long long) meta[b].sample);
+        CHECK(chunk.timestamp == meta[b].utc_ns, "chunk %u stamped %llu, expected %llu",
+              i, (unsigned long long) chunk.timestamp, (unsigned long long) meta[b].utc_ns);
+        CHECK(m > 0 && memcmp(y, raw + 2 * chunk.sample_offset, 2 * m) == 0,
+              "chunk %u does not decode to its input", i);
+    }
+    CHECK(iqarc_reader_read(r, y, &chunk) == 0, "no end of archive after %u chunks", CHUNKS);
+
+    //  into the last chunk and back
+    CHECK(iqarc_reader_seek(r, index[2].timestamp + 1000) == 2, "seek did not find the last chunk");
+    CHECK(iqarc_reader_read(r, y, &chunk) == IQARC_CHUNK_SAMPLES &&
+          memcmp(y, raw + 2 * chunk.sample_offset, 2 * IQARC_CHUNK_SAMPLES) == 0,
+          "last chunk decodes differently after a seek");
+    CHECK(iqarc_reader_seek(r, index[0].timestamp) == 0, "seek did not find the first chunk");
+    CHECK(iqarc_reader_seek(r, index[2].timestamp + 10ULL * 1000000000ULL) == -1,
+          "seek past the end found a chunk");
+
+    iqarc_reader_destroy(&r);
+    unlink(ARCHIVE);
+    free(meta);
+    free(y);
+    free(raw);
+}
+
+//  Two dropped LSBs decode within 2 of the input; a gap in the capture
+//  tags ends the chunk and the next one starts at the tagged sample
+static void test_shift_gap(void)
+{
+    unsigned int n = 6 * BLOCK, i, k, err = 0;
+    const iqarc_index_t *index;
+    iqarc_index_t chunk;
+    blockmeta_t meta = { 0 };
+    uint8_t *raw = make_iq(n);
+    uint8_t *y = malloc(2 * IQARC_CHUNK_SAMPLES);
+    assert(y);
+
+    unlink(ARCHIVE);
+    iqarc_writer_t *w = iqarc_writer_create(ARCHIVE, RATE, FREQ, 2);
+    CHECK(w != NULL, "cannot create '%s'", ARCHIVE);
+    if (w == NULL)
+        return;
+    iqarc_writer_set_blocking(w, 1);
+
+    meta.rate = RATE;
+    meta.utc_ns = 1700000000000000000ULL;
+    for (i = 0; i < 6; i++) {
+        //  5000 samples lost before the fourth block
+        meta.gap = (i == 3) ? 5000 : 0;
+        meta.sample += meta.gap;
+        meta.utc_ns += meta.gap * 1000000000ULL / RATE;
+        meta.n = BLOCK;
+        iqarc_writer_write(w, raw + 2 * i * BLOCK, BLOCK, &meta);
+        meta.sample += BLOCK;
+        meta.utc_ns += BLOCK * 1000000000ULL / RATE;
+    }
+    CHECK(iqarc_writer_close(w) == 0, "close failed");
+    iqarc_writer_destroy(&w);
+
+    iqarc_reader_t *r = iqarc_reader_open(ARCHIVE);
+    CHECK(r != NULL, "cannot open '%s'", ARCHIVE);
+    if (r == NULL)
+        return;
+
+    CHECK(iqarc_reader_info(r)->shift == 2, "header shift %u, expected 2", iqarc_reader_info(r)->shift);
+    CHECK(iqarc_reader_index(r, &index) == 2, "index has %u entries, expected 2",
+          iqarc_reader_index(r, &index));
+    CHECK(index[1].sample_offset == 3 * BLOCK + 5000, "second chunk starts at %llu, expected %u",
+          (unsigned long long) index[1].sample_offset, 3 * BLOCK + 5000);
+
+    for (i = 0; i < 2; i++) {
+        int m = iqarc_reader_read(r, y, &chunk);
+        CHECK(m == 3 * BLOCK, "chunk %u has %d samples, expected %u", i, m, 3 * BLOCK);
+        for (k = 0; m > 0 && k < 2 * (unsigned int) m; k++) {
+            unsigned int e = abs((int) y[k] - (int) raw[2 * i * 3 * BLOCK + k]);
+            if (e > err)
+                err = e;
+        }
+    }
+    printf("shift 2         :   max error %u\n", err);
+    CHECK(err <= 2, "shift 2 decodes with error up to %u, expected <= 2", err);
+
+    iqarc_reader_destroy(&r);
+    unlink(ARCHIVE);
+    free(y);
+    free(raw);
+}
+
+//  A trailer with a bogus entry count, or none at all after a crash,
+//  falls back to walking the chunk headers
+static void test_damaged(void)
+{
+    unsigned int n = 3 * BLOCK, i;
+    const iqarc_index_t *index;
+    uint8_t *raw = make_iq(n);
+    uint8_t *y = malloc(2 * IQARC_CHUNK_SAMPLES);
+    uint8_t bogus[8] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f };
+    blockmeta_t meta = { 0 };
+    long size;
+    assert(y);
+
+    unlink(ARCHIVE);
+    iqarc_writer_t *w = iqarc_writer_create(ARCHIVE, RATE, FREQ, 0);
+    CHECK(w != NULL, "cannot create '%s'", ARCHIVE);
+    if (w == NULL)
+        return;
+    iqarc_writer_set_blocking(w, 1);
+
+    //  two chunks, split by a gap
+    meta.rate = RATE;
+    for (i = 0; i < 3; i++) {
+        meta.sample = i * BLOCK + ((i == 2) ? 1000 : 0);
+        meta.utc_ns = 1700000000000000000ULL + meta.sample * 1000000000ULL / RATE;
+        meta.n = BLOCK;
+        iqarc_writer_write(w, raw + 2 * i * BLOCK, BLOCK, &meta);
+    }
+    iqarc_writer_close(w);
+    iqarc_writer_destroy(&w);
+
+    //  entry count of the trailer, 24 bytes from the end
+    FILE *fid = fopen(ARCHIVE, "r+b");
+    assert(fid);
+    fseek(fid, -24, SEEK_END);
+    fwrite(bogus, sizeof(bogus), 1, fid);
+    fseek(fid, 0, SEEK_END);
+    size = ftell(fid);
+    fclose(fid);
+
+    iqarc_reader_t *r = iqarc_reader_open(ARCHIVE);
+    CHECK(r != NULL, "archive with a bad trailer does not open");
+    if (r) {
+        CHECK(iqarc_reader_index(r, &index) == 2, "bad trailer: %u chunks found, expected 2",
+              iqarc_reader_index(r, &index));
+        CHECK(iqarc_reader_read(r, y, NULL) == 2 * BLOCK && memcmp(y, raw, 4 * BLOCK) == 0,
+              "bad trailer: first chunk does not decode");
+        iqarc_reader_destroy(&r);
+    }
+
+    //  cut into the last chunk: only the first one is left
+    CHECK(truncate(ARCHIVE, size - 24 - 2 * 28 - 100) == 0, "cannot truncate '%s'", ARCHIVE);
+    r = iqarc_reader_open(ARCHIVE);
+    CHECK(r != NULL, "truncated archive does not open");
+    if (r) {
+        CHECK(iqarc_reader_index(r, &index) == 1, "truncated: %u chunks found, expected 1",
+              iqarc_reader_index(r, &index));
+        iqarc_reader_destroy(&r);
+    }
+
+    unlink(ARCHIVE);
+    free(y);
+    free(raw);
+}
+
+int main(void)
+{
+    test_lossless();
+    test_shift_gap();
+    test_damaged();
+
+    return test_failures ? 1 : 0;
+}
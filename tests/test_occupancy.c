@@ -0,0 +1,174 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Occupancy store: per bin statistics, percentiles up to the top of the
+//  histogram, time range selection, persistence and layout checks
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define STORE   "test_occupancy.occ"
+#define NBINS   4
+#define T0      1700000000000000000ULL      //  multiple of the bucket length
+#define SEC     1000000000ULL
+#define SEQ_OFFSET  64                      //  update counter in the header
+
+static void check_pct(occupancy_t *occ, unsigned int bin, float pct, float expected)
+{
+    occupancy_stats_t st;
+
+    occupancy_query(occ, T0, T0 + 10 * SEC, bin, pct, &st);
+    CHECK(st.percentile == expected, "bin %u p%.0f = %.1f dB, expected %.1f dB",
+          bin, pct, st.percentile, expected);
+}
+
+//  Bin 0 cycles through -20/-3/0/+6 dB, bin 1 stays idle, bin 2 is busy
+//  one frame in four, bin 3 is strong enough to need the top of the
+//  histogram
+static void check_stats(occupancy_t *occ, const char *what)
+{
+    occupancy_stats_t st;
+
+    printf("%s\n", what);
+
+    CHECK(occupancy_query(occ, T0, T0 + 10 * SEC, 0, 50.0f, &st) == 0, "first bucket has no data");
+    printf("  bin 0: %llu frames, min %.1f, max %.1f, mean %.2f dB, duty %.2f\n",
+           (unsigned long long) st.frames, st.min, st.max, st.mean, st.duty);
+    CHECK(st.frames == 100, "%llu frames in the first bucket, expected 100", (unsigned long long) st.frames);
+    CHECK(st.min == -20.0f && st.max == 6.0f, "bin 0 range %.1f..%.1f dB, expected -20..6 dB", st.min, st.max);
+    CHECK(fabsf(st.mean - 1.376f) < 0.01f, "bin 0 mean %.3f dB, expected 1.376 dB", st.mean);
+    CHECK(st.duty == 0.75f, "bin 0 duty %.2f, expected 0.75", st.duty);
+
+    //  upper edge of the histogram bin, clamped to the observed range
+    check_pct(occ, 0, 20.0f, -18.0f);
+    check_pct(occ, 0, 45.0f, -2.0f);
+    check_pct(occ, 0, 70.0f, 2.0f);
+    check_pct(occ, 0, 95.0f, 6.0f);
+
+    occupancy_query(occ, T0, T0 + 10 * SEC, 1, 50.0f, &st);
+    CHECK(st.duty == 0.0f && st.max == -100.0f, "idle bin duty %.2f, max %.1f dB", st.duty, st.max);
+
+    occupancy_query(occ, T0, T0 + 10 * SEC, 2, 50.0f, &st);
+    CHECK(st.duty == 0.25f, "bin 2 duty %.2f, expected 0.25", st.duty);
+
+    check_pct(occ, 3, 50.0f, 8.0f);
+    check_pct(occ, 3, 95.0f, 10.0f);
+
+    //  both buckets, the gap between them, past the end
+    occupancy_query(occ, T0, T0 + 30 * SEC, 0, 50.0f, &st);
+    CHECK(st.frames == 200, "%llu frames in both buckets, expected 200", (unsigned long long) st.frames);
+    CHECK(occupancy_query(occ, T0 + 10 * SEC, T0 + 20 * SEC, 0, 50.0f, &st) == -1,
+          "empty range returned data");
+    CHECK(occupancy_query(occ, T0, T0 + 10 * SEC, NBINS, 50.0f, &st) == -1,
+          "bin past the end returned data");
+}
+
+int main(void)
+{
+    occupancy_info_t info = {
+        .nbins = NBINS,
+        .n_buckets = 8,
+        .frequency = 100000000,
+        .bandwidth = 2048000.0,
+        .bucket_seconds = 10.0,
+        .threshold = -10.0f,
+    };
+    static const float levels[] = { -20.0f, -3.0f, 0.0f, 6.0f };
+    float psd[NBINS];
+    unsigned int i, b;
+
+    unlink(STORE);
+    occupancy_t *occ = occupancy_create(STORE, &info);
+    CHECK(occ != NULL, "cannot create '%s'", STORE);
+    if (occ == NULL)
+        return 1;
+
+    //  100 frames 50 ms apart in each of two buckets, 20 s apart
+    for (b = 0; b < 2; b++)
+        for (i = 0; i < 100; i++) {
+            psd[0] = levels[i % 4];
+            psd[1] = -100.0f;
+            psd[2] = (i % 4 == 0) ? -5.0f : -50.0f;
+            psd[3] = (i % 4 == 3) ? 10.0f : 6.0f;
+            occupancy_update(occ, psd, T0 + b * 20 * SEC + i * (SEC / 20));
+        }
+
+    check_stats(occ, "writer");
+    occupancy_destroy(&occ);
+
+    occ = occupancy_open(STORE);
+    CHECK(occ != NULL, "cannot reopen '%s'", STORE);
+    if (occ) {
+        CHECK(occupancy_info(occ)->nbins == NBINS && occupancy_info(occ)->bucket_seconds == 10.0,
+              "reopened store has a different layout");
+        check_stats(occ, "reader");
+        occupancy_destroy(&occ);
+    }
+
+    //  an existing store keeps its layout
+    info.nbins = NBINS + 1;
+    occ = occupancy_create(STORE, &info);
+    CHECK(occ == NULL, "store reopened with %u bins instead of %u", NBINS + 1, NBINS);
+    occupancy_destroy(&occ);
+
+    //  a zero bucket length or count is refused, not divided by
+    info.nbins = NBINS;
+    info.bucket_seconds = 0.0;
+    occ = occupancy_create(STORE "0", &info);
+    CHECK(occ == NULL, "store created with zero bucket length");
+    occupancy_destroy(&occ);
+    info.bucket_seconds = 10.0;
+    info.n_buckets = 0;
+    occ = occupancy_create(STORE "0", &info);
+    CHECK(occ == NULL, "store created with zero buckets");
+    occupancy_destroy(&occ);
+    info.n_buckets = 8;
+    unlink(STORE "0");
+
+    //  a writer killed mid-update leaves the counter odd: readers give
+    //  up instead of spinning, the next writer recovers the store
+    uint64_t seq;
+    int fd = open(STORE, O_RDWR);
+    CHECK(fd >= 0 && pread(fd, &seq, sizeof(seq), SEQ_OFFSET) == sizeof(seq), "cannot read '%s'", STORE);
+    seq |= 1;
+    CHECK(fd >= 0 && pwrite(fd, &seq, sizeof(seq), SEQ_OFFSET) == sizeof(seq), "cannot write '%s'", STORE);
+    if (fd >= 0)
+        close(fd);
+
+    occupancy_stats_t st;
+    occ = occupancy_open(STORE);
+    CHECK(occ && occupancy_query(occ, T0, T0 + 10 * SEC, 0, 50.0f, &st) == -2,
+          "query on a store left mid-update did not give up");
+    occupancy_destroy(&occ);
+
+    occ = occupancy_create(STORE, &info);
+    CHECK(occ && occupancy_query(occ, T0, T0 + 10 * SEC, 0, 50.0f, &st) == 0 && st.frames == 100,
+          "writer did not recover the store left mid-update");
+    occupancy_destroy(&occ);
+
+    unlink(STORE);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Averaging spectrum: tone in the right bin at the right level, clean
+//  elsewhere, partial batches transformed and counted
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define RATE    2048000
+#define NFFT    256
+#define BIN     40                              //  tone offset in bins
+#define OFFSET  ((float)BIN * RATE / NFFT)      //  320 kHz
+
+//  Peak bin and level, worst bin further than 2 bins from the peak
+static void check_tone(const char *what, const float *psd, double level, double limit)
+{
+    unsigned int i, peak = 0;
+    float worst = -1e30f;
+
+    for (i = 1; i < NFFT; i++)
+        if (psd[i] > psd[peak])
+            peak = i;
+    for (i = 0; i < NFFT; i++)
+        if (abs((int)i - (int)peak) > 2 && psd[i] > worst)
+            worst = psd[i];
+
+    printf("%-16s:   peak bin %u at %.2f dB, worst other bin %.1f dB\n", what, peak, psd[peak], worst);
+    CHECK(peak == NFFT / 2 + BIN, "%s: peak in bin %u, expected %u", what, peak, NFFT / 2 + BIN);
+    CHECK(fabs(psd[peak] - level) < 0.2, "%s: peak %.2f dB, expected %.2f dB", what, psd[peak], level);
+    CHECK(worst < limit, "%s: other bins up to %.1f dB, expected < %.0f dB", what, worst, limit);
+}
+
+static void test_tone(void)
+{
+    unsigned int n = 100 * NFFT, frames;
+    float psd[NFFT];
+
+    complex float *x = malloc(n * sizeof(complex float));
+    assert(x);
+
+    siggen_t *gen = siggen_create(RATE, 1);
+    siggen_add_fm_tone(gen, OFFSET, 0.5f, 0.0f, 0.0f);
+    siggen_generate(gen, x, n);
+    siggen_destroy(&gen);
+
+    spectrum_t *spec = spectrum_create(NFFT);
+
+    //  one full batch and a partial one
+    spectrum_write(spec, x, n);
+    CHECK(spectrum_frames(spec) == 100, "%u frames pending, expected 100", spectrum_frames(spec));
+    frames = spectrum_read(spec, psd);
+    CHECK(frames == 100, "read averaged %u frames, expected 100", frames);
+    check_tone("float tone", psd, -6.02, -80.0);
+
+    //  partial batch only, written in uneven pieces
+    spectrum_write(spec, x, 100);
+    spectrum_write(spec, x + 100, 3 * NFFT - 100 + 10);
+    frames = spectrum_read(spec, psd);
+    CHECK(frames == 3, "partial batch averaged %u frames, expected 3", frames);
+    check_tone("partial batch", psd, -6.02, -80.0);
+
+    //  nothing pending leaves psd alone
+    psd[0] = 1.0f;
+    frames = spectrum_read(spec, psd);
+    CHECK(frames == 0 && psd[0] == 1.0f, "empty read returned %u frames", frames);
+
+    spectrum_destroy(&spec);
+    free(x);
+}
+
+int main(void)
+{
+    test_tone();
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Capture tags for file input and their mapping to channel rates,
+//  including two channels fed from one capture
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define RATE        2048000
+#define BLOCK       16384
+#define OUT_RATE    24000
+#define OUT_BLOCK   (BLOCK * OUT_RATE / RATE)   //  192
+#define DELAY       10.0f                       //  filter delay [output samples]
+#define NBLOCKS     1000
+#define OUT_RATE2   48000
+#define DELAY2      5.0f
+#define GAP_AT      500                         //  block following a simulated loss
+#define GAP         (4 * BLOCK)
+
+static int64_t diff(uint64_t a, uint64_t b)
+{
+    return (int64_t)(a - b);
+}
+
+//  Two channels on one capture keep their own sample counts, and each
+//  reports a loss once, at its own rate
+static void test_two_channels(void)
+{
+    timetag_map_t map1, map2;
+    blockmeta_t in, out1, out2;
+    uint64_t gap1 = 0, gap2 = 0;
+    unsigned int i, bad = 0;
+
+    timetag_t *tt = timetag_create(RATE, 0);
+    timetag_map_init(&map1, RATE, OUT_RATE, DELAY);
+    timetag_map_init(&map2, RATE, OUT_RATE2, DELAY2);
+
+    for (i = 0; i < NBLOCKS; i++) {
+        timetag_capture(tt, BLOCK, &in);
+        //  file input never loses samples, so fake what a live gap
+        //  looks like in the tags
+        if (i >= GAP_AT)
+            in.sample += GAP;
+        if (i == GAP_AT)
+            in.gap = GAP;
+
+        timetag_output(&map1, &in, OUT_BLOCK, &out1);
+        timetag_output(&map2, &in, 2 * OUT_BLOCK, &out2);
+        gap1 += out1.gap;
+        gap2 += out2.gap;
+
+        if (out1.sample != (uint64_t) i * OUT_BLOCK || out1.rate != OUT_RATE ||
+            out2.sample != (uint64_t) i * 2 * OUT_BLOCK || out2.rate != OUT_RATE2 ||
+            (out1.gap != 0) != (i == GAP_AT) || (out2.gap != 0) != (i == GAP_AT))
+            bad++;
+    }
+
+    printf("two channels    :   %u of %u blocks wrong, gaps %llu and %llu\n", bad, NBLOCKS,
+           (unsigned long long) gap1, (unsigned long long) gap2);
+    CHECK(bad == 0, "%u blocks wrong with two channels", bad);
+    CHECK(gap1 == (uint64_t) GAP * OUT_RATE / RATE, "first channel gap %llu", (unsigned long long) gap1);
+    CHECK(gap2 == (uint64_t) GAP * OUT_RATE2 / RATE, "second channel gap %llu", (unsigned long long) gap2);
+
+    timetag_destroy(&tt);
+}
+
+int main(void)
+{
+    blockmeta_t in, prev = { 0 }, out;
+    int64_t step = (int64_t) BLOCK * 1000000000LL / RATE;
+    int64_t shift = -(int64_t)(DELAY * 1e9 / OUT_RATE + 0.5);
+    unsigned int i, bad_in = 0, bad_out = 0;
+    char buf[32];
+    timetag_map_t map;
+
+    //  file input: tags follow the sample count
+    timetag_t *tt = timetag_create(RATE, 0);
+    timetag_map_init(&map, RATE, OUT_RATE, DELAY);
+
+    for (i = 0; i < NBLOCKS; i++) {
+        timetag_capture(tt, BLOCK, &in);
+        timetag_output(&map, &in, OUT_BLOCK, &out);
+
+        if (in.seq != i || in.sample != (uint64_t) i * BLOCK || in.gap != 0 ||
+            in.n != BLOCK || in.rate != RATE ||
+            (i > 0 && llabs(diff(in.utc_ns, prev.utc_ns) - step) > 2) ||
+            (i > 0 && diff(in.utc_ns, in.mono_ns) != diff(prev.utc_ns, prev.mono_ns)))
+            bad_in++;
+
+        //  output samples are contiguous and lag by the filter delay
+        if (out.seq != i || out.sample != (uint64_t) i * OUT_BLOCK || out.gap != 0 ||
+            out.n != OUT_BLOCK || out.rate != OUT_RATE ||
+            llabs(diff(out.utc_ns, in.utc_ns) - shift) > 2)
+            bad_out++;
+
+        prev = in;
+    }
+
+    printf("capture tags    :   %u of %u blocks wrong\n", bad_in, NBLOCKS);
+    printf("output tags     :   %u of %u blocks wrong, lag %lld ns\n", bad_out, NBLOCKS,
+           (long long) diff(out.utc_ns, in.utc_ns));
+    CHECK(bad_in == 0, "%u capture tags wrong", bad_in);
+    CHECK(bad_out == 0, "%u output tags wrong", bad_out);
+    CHECK(timetag_lost(tt) == 0, "file input lost %llu samples", (unsigned long long) timetag_lost(tt));
+
+    timetag_destroy(&tt);
+
+    test_two_channels();
+
+    timetag_format_utc(1700000000123456789ULL, buf, sizeof(buf));
+    printf("format          :   %s\n", buf);
+    CHECK(strcmp(buf, "2023-11-14T22:13:20.123456Z") == 0, "formatted as '%s'", buf);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+/*  =========================================================================
+    Copyright (c) 2013 Mariusz Ryndzionek - mryndzionek@gmail.com
+
+    This is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+    This software is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTA-
+    BILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General
+    Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/.
+    =========================================================================
+ */
+
+//  Goertzel bank: each tone measured at its own level and nowhere else
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sdr_rec.h"
+#include "test.h"
+
+#define RATE    2048000
+#define WINDOW  2048
+#define BLOCK   10000       //  frames straddle blocks
+
+int main(void)
+{
+    static const float offsets[] = { 320000.0f, -500000.0f, 1000.0f };
+    unsigned int ntones = sizeof(offsets) / sizeof(offsets[0]);
+    unsigned int n = 50 * WINDOW, i, j, k, frames;
+    float power[TONEBANK_MAX_TONES];
+
+    complex float *x = malloc(n * sizeof(complex float));
+    assert(x);
+
+    //  one tone at a time, then all of them
+    for (j = 0; j <= ntones; j++) {
+        siggen_t *gen = siggen_create(RATE, 1);
+        for (k = 0; k < ntones; k++)
+            if (k == j || j == ntones)
+                siggen_add_fm_tone(gen, offsets[k], 0.5f, 0.0f, 0.0f);
+        siggen_generate(gen, x, n);
+        siggen_destroy(&gen);
+
+        tonebank_t *bank = tonebank_create(offsets, ntones, RATE, WINDOW);
+        for (i = 0; i < n; i += BLOCK)
+            tonebank_execute(bank, x + i, (n - i < BLOCK) ? n - i : BLOCK);
+        frames = tonebank_read(bank, power);
+        CHECK(frames == n / WINDOW, "averaged %u frames, expected %u", frames, n / WINDOW);
+
+        for (k = 0; k < ntones; k++) {
+            int on = (k == j || j == ntones);
+            printf("tone %u of %s: %9.0f Hz at %7.2f dB\n", k, (j == ntones) ? "all" : "one",
+                   offsets[k], power[k]);
+            if (on)
+                CHECK(fabs(power[k] + 6.02) < 0.5, "tone at %.0f Hz read %.2f dB, expected -6.02 dB",
+                      offsets[k], power[k]);
+            else
+                CHECK(power[k] < -80.0, "idle tone at %.0f Hz read %.2f dB, expected < -80 dB",
+                      offsets[k], power[k]);
+        }
+
+        frames = tonebank_read(bank, power);
+        CHECK(frames == 0, "second read averaged %u frames, expected 0", frames);
+        tonebank_destroy(&bank);
+    }
+
+    free(x);
+
+    return test_failures ? 1 : 0;
+}